@@ -0,0 +1,209 @@
+/*
+ * Microbenchmarks for GenomicSQLite hot paths, on google-benchmark. Not built by default:
+ *
+ *   cmake -DGENOMICSQLITE_BENCH=ON -B build . && cmake --build build --target genomicsqlite_bench
+ *   build/bench/genomicsqlite_bench
+ *
+ * Pass --benchmark_format=json (or --benchmark_out=...) for machine-readable results to track
+ * across versions.
+ */
+#include <benchmark/benchmark.h>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+#include <sqlite3.h>
+
+#include "genomicsqlite.h"
+
+using namespace std;
+
+static void bench_init() {
+    static bool done = false;
+    if (!done) {
+        GENOMICSQLITE_CXX_INIT();
+        done = true;
+    }
+}
+
+static void exec_or_throw(sqlite3 *db, const string &sql) {
+    char *errmsg = nullptr;
+    if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errmsg) != SQLITE_OK) {
+        string msg = errmsg ? errmsg : "sqlite3_exec() failed";
+        sqlite3_free(errmsg);
+        throw runtime_error(msg);
+    }
+}
+
+static sqlite3 *open_or_throw(const string &dbfile, int flags, const string &config_json = "{}") {
+    sqlite3 *db = nullptr;
+    string errmsg;
+    if (GenomicSQLiteOpen(dbfile, &db, errmsg, flags, config_json) != SQLITE_OK) {
+        sqlite3_close_v2(db);
+        throw runtime_error(errmsg);
+    }
+    return db;
+}
+
+// Build (once per table size) a GRI-indexed table of nrows random reads across four reference
+// sequences, and keep a read-only connection open across benchmark iterations.
+static sqlite3 *bench_table(long long nrows) {
+    static map<long long, sqlite3 *> cache;
+    auto hit = cache.find(nrows);
+    if (hit != cache.end()) {
+        return hit->second;
+    }
+    string dbfile = "/tmp/genomicsqlite_bench_" + to_string(nrows) + ".gsql";
+    unlink(dbfile.c_str());
+    sqlite3 *db = open_or_throw(dbfile, SQLITE_OPEN_CREATE | SQLITE_OPEN_READWRITE,
+                                R"({"unsafe_load": true})");
+    exec_or_throw(db, "CREATE TABLE reads(rid INTEGER, beg INTEGER, end INTEGER)");
+    sqlite3_stmt *ins = nullptr;
+    if (sqlite3_prepare_v2(db, "INSERT INTO reads(rid,beg,end) VALUES(?,?,?)", -1, &ins,
+                           nullptr) != SQLITE_OK) {
+        throw runtime_error(sqlite3_errmsg(db));
+    }
+    mt19937_64 rng(nrows);
+    uniform_int_distribution<long long> rid_dist(1, 4), beg_dist(0, 100000000),
+        len_dist(100, 300);
+    exec_or_throw(db, "BEGIN");
+    for (long long i = 0; i < nrows; ++i) {
+        sqlite3_bind_int64(ins, 1, rid_dist(rng));
+        long long beg = beg_dist(rng);
+        sqlite3_bind_int64(ins, 2, beg);
+        sqlite3_bind_int64(ins, 3, beg + len_dist(rng));
+        if (sqlite3_step(ins) != SQLITE_DONE) {
+            throw runtime_error(sqlite3_errmsg(db));
+        }
+        sqlite3_reset(ins);
+    }
+    sqlite3_finalize(ins);
+    exec_or_throw(db, "COMMIT");
+    exec_or_throw(db, CreateGenomicRangeIndexSQL("reads", "rid", "beg", "end"));
+    sqlite3_close_v2(db);
+
+    db = open_or_throw(dbfile, SQLITE_OPEN_READONLY);
+    cache[nrows] = db;
+    return db;
+}
+
+// connection open+close latency (includes URI generation, config parse & tuning script)
+static void BM_OpenClose(benchmark::State &state) {
+    bench_init();
+    sqlite3 *db = bench_table(100000); // ensure file exists
+    (void)db;
+    string dbfile = "/tmp/genomicsqlite_bench_100000.gsql";
+    for (auto _ : state) {
+        sqlite3 *conn = open_or_throw(dbfile, SQLITE_OPEN_READONLY);
+        sqlite3_close_v2(conn);
+    }
+}
+BENCHMARK(BM_OpenClose);
+
+// URI + tuning script generation with the memoized config parse (steady-state open path)
+static void BM_AttachSQL(benchmark::State &state) {
+    bench_init();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(GenomicSQLiteAttachSQL("/tmp/bench.gsql", "aux1"));
+    }
+}
+BENCHMARK(BM_AttachSQL);
+
+// ...and with a unique config JSON per iteration, defeating the memo (cold open path)
+static void BM_AttachSQLUncached(benchmark::State &state) {
+    bench_init();
+    long long i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(GenomicSQLiteAttachSQL(
+            "/tmp/bench.gsql", "aux1", R"({"zstd_level": )" + to_string(i++ % 20) + "}"));
+    }
+}
+BENCHMARK(BM_AttachSQLUncached);
+
+// GRI query SQL generation, including the DetectLevelRange() index inspection
+static void BM_RangeRowidsSQL(benchmark::State &state) {
+    bench_init();
+    sqlite3 *db = bench_table(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(GenomicRangeRowidsSQL(db, "reads"));
+    }
+}
+BENCHMARK(BM_RangeRowidsSQL)->Arg(100000)->Arg(1000000);
+
+// GRI query execution; range(1) = query window width (point-ish and batch scans)
+static void BM_RangeQuery(benchmark::State &state) {
+    bench_init();
+    sqlite3 *db = bench_table(state.range(0));
+    string sql = "SELECT COUNT(*) FROM " + GenomicRangeRowidsSQL(db, "reads");
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        throw runtime_error(sqlite3_errmsg(db));
+    }
+    mt19937_64 rng(42);
+    uniform_int_distribution<long long> rid_dist(1, 4), beg_dist(0, 100000000);
+    long long rows = 0;
+    for (auto _ : state) {
+        sqlite3_bind_int64(stmt, 1, rid_dist(rng));
+        long long beg = beg_dist(rng);
+        sqlite3_bind_int64(stmt, 2, beg);
+        sqlite3_bind_int64(stmt, 3, beg + state.range(1));
+        if (sqlite3_step(stmt) != SQLITE_ROW) {
+            throw runtime_error(sqlite3_errmsg(db));
+        }
+        rows += sqlite3_column_int64(stmt, 0);
+        sqlite3_reset(stmt);
+    }
+    state.counters["result_rows"] =
+        benchmark::Counter((double)rows, benchmark::Counter::kIsRate);
+    sqlite3_finalize(stmt);
+}
+BENCHMARK(BM_RangeQuery)
+    ->Args({100000, 1000})
+    ->Args({100000, 100000})
+    ->Args({1000000, 1000})
+    ->Args({1000000, 100000});
+
+// two-bit nucleotide encode/decode throughput
+static string random_dna(size_t len) {
+    mt19937_64 rng(len);
+    const char *alphabet = "ACGT";
+    string dna;
+    dna.reserve(len);
+    for (size_t i = 0; i < len; ++i) {
+        dna += alphabet[rng() % 4];
+    }
+    return dna;
+}
+
+static void BM_NucleotidesTwobit(benchmark::State &state) {
+    bench_init();
+    string dna = random_dna(state.range(0));
+    unique_ptr<char[]> buf(new char[dna.size() / 4 + 2]);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(nucleotides_twobit(dna.c_str(), dna.size(), buf.get()));
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * dna.size());
+}
+BENCHMARK(BM_NucleotidesTwobit)->Arg(151)->Arg(10000)->Arg(1000000);
+
+static void BM_TwobitDna(benchmark::State &state) {
+    bench_init();
+    string dna = random_dna(state.range(0));
+    unique_ptr<char[]> blob(new char[dna.size() / 4 + 2]);
+    int blob_sz = nucleotides_twobit(dna.c_str(), dna.size(), blob.get());
+    if (blob_sz < 0) {
+        throw runtime_error("nucleotides_twobit() failed");
+    }
+    unique_ptr<char[]> out(new char[dna.size() + 1]);
+    for (auto _ : state) {
+        twobit_dna(blob.get(), blob_sz, 0, dna.size(), out.get());
+        benchmark::DoNotOptimize(out.get());
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * dna.size());
+}
+BENCHMARK(BM_TwobitDna)->Arg(151)->Arg(10000)->Arg(1000000);
+
+BENCHMARK_MAIN();
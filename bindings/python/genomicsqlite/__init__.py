@@ -124,6 +124,10 @@ def genomic_range_rowids_sql(
     )
 
 
+def put_genomic_range_index_levels_sql(conn: sqlite3.Connection, table: str) -> str:
+    return _execute1(conn, "SELECT put_genomic_range_index_levels_sql(?)", (table,))
+
+
 def put_reference_assembly_sql(
     conn: sqlite3.Connection, assembly: str, schema: Optional[str] = None
 ) -> str:
@@ -51,6 +51,40 @@ int genomicsqlite_init(int (*)(const char *, sqlite3 **, int, const char *),
 int genomicsqlite_open(const char *dbfile, sqlite3 **ppDb, char **pzErrMsg, int flags,
                        const char *config_json);
 
+/*
+ * Pool of connections to one GenomicSQLite database, for request-scoped usage where opening a
+ * fresh connection per request would start with cold page & compression-layer caches. Checkout
+ * hands out an idle pooled connection if available (warm from its prior use), otherwise opens a
+ * new one; once max_connections are outstanding it blocks until one is checked back in. Checked
+ * out connections must be returned via checkin, not closed. Thread-safe.
+ */
+typedef struct genomicsqlite_pool genomicsqlite_pool;
+int genomicsqlite_pool_create(const char *dbfile, int flags, const char *config_json,
+                              int max_connections, genomicsqlite_pool **ppPool, char **pzErrMsg);
+int genomicsqlite_pool_checkout(genomicsqlite_pool *pool, sqlite3 **ppDb, char **pzErrMsg);
+void genomicsqlite_pool_checkin(genomicsqlite_pool *pool, sqlite3 *db);
+/* Close all idle connections & free the pool; all checkouts must have been checked back in. */
+void genomicsqlite_pool_destroy(genomicsqlite_pool *pool);
+
+/*
+ * Scatter/gather scan of a GRI-indexed database across a pool of parallel reader connections
+ * (SQLite otherwise executes each query on one thread, regardless of the $.threads setting).
+ * The work is partitioned by reference sequence: sql runs once per distinct _gri_rid found in
+ * _gri_refseq, with ?1 bound to the partition's rid -- e.g.
+ *   "SELECT COUNT(*), SUM(endpos-pos) FROM reads WHERE reads._rowid_ IN
+ *      genomic_range_rowids('reads', ?1, 0, 0x10000000000)"
+ * Each result row is passed to row_callback (serialized; rows of one partition arrive together &
+ * in order, but partitions complete in arbitrary order); returning nonzero from the callback
+ * stops the scan without error. The sqlite3_stmt* supplied to the callback is positioned on the
+ * row for sqlite3_column_*() access only. On success *pnRows (if non-null) is set to the number
+ * of rows delivered. Returns an SQLite error code; on failure *pzErrMsg (if non-null) is set to a
+ * message which caller should sqlite3_free()
+ */
+int genomicsqlite_parallel_scan(const char *dbfile, const char *config_json, const char *sql,
+                                int max_connections,
+                                int (*row_callback)(void *ctx, sqlite3_stmt *row), void *ctx,
+                                sqlite3_int64 *pnRows, char **pzErrMsg);
+
 /*
  * Generate SQL script to run on existing SQLite connection (not necessarily GenomicSQLite) to
  * attach a GenomicSQLite database file under the given schema name, with given configuration. The
@@ -66,6 +100,16 @@ char *genomicsqlite_attach_sql(const char *dbfile, const char *schema_name,
  */
 char *genomicsqlite_vacuum_into_sql(const char *destfile, const char *config_json);
 
+/*
+ * Convenience wrapper: copy an existing GenomicSQLite database into a defragmented & recompressed
+ * file in one call, without the caller managing a connection. Opens its own read-only connection
+ * to srcfile and executes the genomicsqlite_vacuum_into_sql() script on it. Returns an SQLite
+ * error code; on failure *pzErrMsg (if non-null) is set to a message which caller should
+ * sqlite3_free()
+ */
+int genomicsqlite_vacuum_into(const char *srcfile, const char *destfile, char **pzErrMsg,
+                              const char *config_json);
+
 /*
  * Generate SQL script to create a genomic range index on the specified table.
  * rid: column name for the reference sequence (chromosome) ID of each row
@@ -75,6 +119,29 @@ char *genomicsqlite_vacuum_into_sql(const char *destfile, const char *config_jso
 char *create_genomic_range_index_sql(const char *table, const char *rid, const char *beg,
                                      const char *end, int floor);
 
+/*
+ * Create the genomic range index directly on the given connection (executing the same script as
+ * create_genomic_range_index_sql), with PRAGMA threads temporarily raised so SQLite's sorter can
+ * external-sort the index keys across cores; only the final b-tree append runs serially. Returns
+ * an SQLite error code; on failure *pzErrMsg (if non-null) is set to a message which caller should
+ * sqlite3_free()
+ */
+int create_genomic_range_index(sqlite3 *dbconn, const char *table, const char *rid,
+                               const char *beg, const char *end, int floor, char **pzErrMsg);
+
+/*
+ * Warm caches ahead of latency-critical queries on a GRI-indexed table: run the GRI probe for the
+ * query range and seek the table b-tree to each resulting rowid, pulling the referenced index &
+ * table pages through the VFS (fetch + decompression) into the page cache without materializing
+ * rows. Blocks until complete, so call it from a background thread or spare connection during
+ * think time. On success *pnRows (if non-null) is set to the number of rows whose pages were
+ * touched. Returns an SQLite error code; on failure *pzErrMsg (if non-null) is set to a message
+ * which caller should sqlite3_free()
+ */
+int genomicsqlite_prefetch(sqlite3 *dbconn, const char *table, const char *qrid,
+                           sqlite3_int64 qbeg, sqlite3_int64 qend, sqlite3_int64 *pnRows,
+                           char **pzErrMsg);
+
 /*
  * Generate parenthesized SELECT statement to query the existing genomic range index of the
  * specified table. The query finds table rows which overlap the query range, producing one column
@@ -96,6 +163,16 @@ char *create_genomic_range_index_sql(const char *table, const char *rid, const c
 char *genomic_range_rowids_sql(sqlite3 *dbconn, const char *indexed_table, const char *qrid,
                                const char *qbeg, const char *qend, int ceiling, int floor);
 
+/*
+ * Generate SQL script to persist the level bounds currently occupied in the table's genomic range
+ * index into the small _gri_levels metadata table, making subsequent automatic ceiling/floor
+ * detection (genomic_range_index_levels() and genomic_range_rowids_sql() with dbconn) a
+ * single-row lookup instead of a full index scan on each fresh connection. Should be re-run
+ * whenever the table's contents change; the persisted bounds are a snapshot, like the generated
+ * query SQL itself.
+ */
+char *put_genomic_range_index_levels_sql(sqlite3 *dbconn, const char *table);
+
 /*
  * Optional storage of refrence sequence metadata
  */
@@ -142,6 +219,25 @@ void twobit_rna(const void *data, size_t sz, size_t ofs, size_t len, char *out);
  */
 int dna_revcomp(const char *dna, size_t len, char *out);
 
+/*
+ * Reverse-complement a two-bit-encoded blob directly, without decoding it to text. The out buffer
+ * must be preallocated sz bytes; the result is the two-bit encoding of the reverse complement.
+ */
+void twobit_revcomp(const void *data, size_t sz, void *out);
+
+/*
+ * Decode the nucleotide subsequence [ofs, ofs+len) of a two-bit-encoded blob stored in
+ * table.column at the given rowid, using sqlite3_blob_open() incremental I/O to read only the
+ * bytes covering the window — unlike twobit_dna(column, ...) in SQL, which makes SQLite
+ * materialize the entire blob before slicing. The out buffer must be preallocated len+1 bytes (a
+ * null terminator will be affixed). table may be prefixed "schema." to reach an attached
+ * database. Returns an SQLite error code; on failure *pzErrMsg (if non-null) is set to a message
+ * which caller should sqlite3_free()
+ */
+int genomicsqlite_twobit_fetch(sqlite3 *dbconn, const char *table, const char *column,
+                               sqlite3_int64 rowid, sqlite3_int64 ofs, sqlite3_int64 len,
+                               char *out, char **pzErrMsg);
+
 /*
  * C++ bindings: are liable to throw exceptions except where marked noexcept
  */
@@ -149,6 +245,7 @@ int dna_revcomp(const char *dna, size_t len, char *out);
 }
 
 #include <map>
+#include <memory>
 #include <string>
 
 std::string GenomicSQLiteVersion();
@@ -181,19 +278,57 @@ std::unique_ptr<SQLite::Database> GenomicSQLiteOpen(const std::string &dbfile, i
                                                     const std::string &config_json = "{}");
 #endif
 
+/* C++ flavor of genomicsqlite_pool: Checkout() throws on failure to open a new connection */
+class GenomicSQLitePool {
+  public:
+    GenomicSQLitePool(const std::string &dbfile, int flags = 0,
+                      const std::string &config_json = "{}", size_t max_connections = 16);
+    ~GenomicSQLitePool();
+    sqlite3 *Checkout();
+    void Checkin(sqlite3 *db);
+
+  private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+    GenomicSQLitePool(const GenomicSQLitePool &) = delete;
+};
+
+/*
+ * C++ flavor of genomicsqlite_parallel_scan: returns the number of rows delivered to the
+ * (serialized) callback, which may return nonzero to stop the scan without error; throws on error
+ */
+#include <functional>
+sqlite3_int64 GenomicSQLiteParallelScan(const std::string &dbfile, const std::string &config_json,
+                                        const std::string &sql,
+                                        const std::function<int(sqlite3_stmt *)> &row_callback,
+                                        size_t max_connections = 16);
+
 std::string GenomicSQLiteAttachSQL(const std::string &dbfile, const std::string &schema_name,
                                    const std::string &config_json = "{}");
 
 std::string GenomicSQLiteVacuumIntoSQL(const std::string &dbfile,
                                        const std::string &config_json = "{}");
 
+void GenomicSQLiteVacuumInto(const std::string &srcfile, const std::string &destfile,
+                             const std::string &config_json = "{}");
+
 std::string CreateGenomicRangeIndexSQL(const std::string &table, const std::string &rid,
                                        const std::string &beg, const std::string &end,
                                        int floor = 0);
+void CreateGenomicRangeIndex(sqlite3 *dbconn, const std::string &table, const std::string &rid,
+                             const std::string &beg, const std::string &end, int floor = 0);
+sqlite3_int64 GenomicSQLitePrefetch(sqlite3 *dbconn, const std::string &table,
+                                    const std::string &qrid, sqlite3_int64 qbeg,
+                                    sqlite3_int64 qend);
+std::string GenomicSQLiteTwoBitFetch(sqlite3 *dbconn, const std::string &table,
+                                     const std::string &column, sqlite3_int64 rowid,
+                                     sqlite3_int64 ofs, sqlite3_int64 len, bool rna = false);
 std::string GenomicRangeRowidsSQL(sqlite3 *dbconn, const std::string &indexed_table,
                                   const std::string &qrid = "?1", const std::string &qbeg = "?2",
                                   const std::string &qend = "?3", int ceiling = -1, int floor = -1);
 
+std::string PutGenomicRangeIndexLevelsSQL(sqlite3 *dbconn, const std::string &table);
+
 std::string PutGenomicReferenceAssemblySQL(const std::string &assembly,
                                            const std::string &attached_schema = "");
 std::string PutGenomicReferenceSequenceSQL(const std::string &name, sqlite3_int64 length,
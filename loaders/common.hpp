@@ -232,6 +232,10 @@ template <class Item> class BackgroundProducer {
     // get current item for consumption; defined only after next() returned true
     const Item &item() { return *item_; }
 
+    // mutable access to the current item: the consumer may move/swap its contents out (e.g. to
+    // hand off to another thread), in which case Produce() must tolerate the state left behind
+    Item &item_mut() { return ring_[(c_.load(memory_order_relaxed) - 1) % R_]; }
+
     void abort() {
         stop_.store(true, memory_order_relaxed);
         if (worker_) {
@@ -6,6 +6,7 @@
  *   cross-referenced table. so reader can elect whether to load/decompress the sequences.
  * - tags (written in JSON) also get their own table.
  */
+#include "blockingconcurrentqueue.h"
 #include "common.hpp"
 #include <fstream>
 #include <getopt.h>
@@ -107,63 +108,269 @@ int write_tags_json(const map<string, int> &readgroups, const vector<char *> &sa
     return rg_id;
 }
 
-struct SamItem {
-    shared_ptr<kstring_t> line;
-    vector<char *> fields;
-    shared_ptr<bam1_t> rec;
+// One alignment fully materialized by a parser/encoder worker, so that the writer thread can bind
+// the INSERT statements without touching htslib or splitting any text itself.
+struct SamRow {
+    int flag = 0, mapq = 0, tid = -1, mtid = -1, rg_id = -1;
+    sqlite3_int64 pos = -1, endpos = -1, mpos = -1, tlen = 0;
+    string qname, cigar, seq, qual, tags_json;
+};
 
-    string tags_json;
-    int rg_id = -1;
+// Batch of records flowing reader -> worker -> writer. Batches are recycled through the pipeline
+// so the bam1_t and string buffers get reused instead of reallocated.
+struct SamBatch {
+    long long serial = -1;
+    size_t count = 0;
+    vector<shared_ptr<bam1_t>> recs;
+    vector<SamRow> rows;
+};
 
-    SamItem() {
-        line = kstringXX();
-        rec = shared_ptr<bam1_t>(bam_init1(), &bam_destroy1);
+// Multi-threaded parse/encode pipeline. One reader thread streams bam1_t records off the htslib
+// decoder (inherently serial) into batches; worker threads take batches off a concurrent queue
+// and materialize SamRows (SAM field splitting, tags JSON); the main thread consumes completed
+// batches, restored to original file order, and binds the INSERT statements. Generalizes the
+// single BackgroundProducer thread, which left the consumer compute-bound on large inputs.
+class SamPipeline {
+    static const size_t BATCH = 256;
+
+  public:
+    SamPipeline(samFile *sam, sam_hdr_t *hdr, const map<string, int> &readgroups, size_t workers)
+        : sam_(sam), hdr_(hdr), readgroups_(readgroups), nworkers_(max(size_t(1), workers)) {}
+
+    ~SamPipeline() {
+        stop_.store(true, memory_order_relaxed);
+        if (reader_) {
+            reader_->join();
+        }
+        for (auto &w : workers_) {
+            w.join();
+        }
     }
 
-    void Clear() {
-        line->l = 0;
-        fields.clear();
-        tags_json.clear();
-        rg_id = -1;
+    // advance to the next row for consumption & return true, or return false when the record
+    // stream has ended with success, or throw an exception.
+    bool next() {
+        if (!reader_) {
+            start();
+        }
+        if (current_ && ++cursor_ < current_->count) {
+            row_ = &current_->rows[cursor_];
+            ++rows_;
+            return true;
+        }
+        if (!next_batch()) {
+            return false;
+        }
+        cursor_ = 0;
+        row_ = &current_->rows[0];
+        ++rows_;
+        return true;
     }
-};
 
-class SamReader : public BackgroundProducer<SamItem> {
-  public:
-    SamReader(samFile *sam, bam_hdr_t *hdr, const map<string, int> &readgroups, int ringsize)
-        : BackgroundProducer<SamItem>(ringsize), sam_(sam), hdr_(hdr), readgroups_(readgroups) {}
+    // current row for consumption; defined only after next() returned true
+    const SamRow &item() { return *row_; }
+
+    string log() {
+        chrono::duration<double> elapsed = chrono::high_resolution_clock::now() - t0_;
+        OStringStream ans;
+        ans << to_string(rows_) << " record(s) processed in " << to_string(elapsed.count()) << "s"
+            << " with " << to_string(nworkers_) << " worker(s)"
+            << "; writer blocked for " << to_string(c_blocked_.count()) << "s";
+        return string(ans.Get());
+    }
 
   private:
-    samFile *sam_;
-    bam_hdr_t *hdr_;
-    const map<string, int> &readgroups_;
-    OStringStream tagsbuf_;
-    vector<char *> tagsparsebuf_;
+    void start() {
+        t0_ = chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < nworkers_ * 3 + 4; ++i) {
+            pool_.emplace_back(new SamBatch);
+            pool_.back()->recs.reserve(BATCH);
+            for (size_t j = 0; j < BATCH; ++j) {
+                pool_.back()->recs.push_back(shared_ptr<bam1_t>(bam_init1(), &bam_destroy1));
+            }
+            pool_.back()->rows.resize(BATCH);
+            recycle_.enqueue(pool_.back().get());
+        }
+        reader_.reset(new thread([this]() { this->reader_thread(); }));
+        for (size_t i = 0; i < nworkers_; ++i) {
+            workers_.emplace_back([this]() { this->worker_thread(); });
+        }
+    }
 
-    bool Produce(SamItem &it) override {
-        it.Clear();
-        int ret = sam_read1(sam_, hdr_, it.rec.get());
-        if (ret == -1) {
-            return false;
-        } else if (ret < 0) {
-            throw runtime_error("SAM parser error: sam_read1() -> " + to_string(ret));
+    void reader_thread() {
+        long long serial = 0;
+        try {
+            int ret = 0;
+            while (ret >= 0 && !stop_.load(memory_order_relaxed)) {
+                SamBatch *batch = nullptr;
+                while (!recycle_.wait_dequeue_timed(batch, 100000)) {
+                    if (stop_.load(memory_order_relaxed)) {
+                        batches_read_.store(serial, memory_order_release);
+                        return;
+                    }
+                }
+                batch->serial = serial;
+                batch->count = 0;
+                while (batch->count < BATCH &&
+                       (ret = sam_read1(sam_, hdr_, batch->recs[batch->count].get())) >= 0) {
+                    ++batch->count;
+                }
+                if (ret < -1) {
+                    throw runtime_error("SAM parser error: sam_read1() -> " + to_string(ret));
+                }
+                if (batch->count) {
+                    ++serial;
+                    parse_.enqueue(batch);
+                }
+            }
+        } catch (exception &exn) {
+            fail(exn);
+        }
+        batches_read_.store(serial, memory_order_release);
+    }
+
+    void worker_thread() {
+        auto line = kstringXX();
+        vector<char *> fields, tagsplit;
+        OStringStream tagsbuf;
+        try {
+            while (!stop_.load(memory_order_relaxed)) {
+                SamBatch *batch = nullptr;
+                if (!parse_.wait_dequeue_timed(batch, 100000)) {
+                    long long total = batches_read_.load(memory_order_acquire);
+                    if (total >= 0 && batches_parsed_.load(memory_order_acquire) >= total) {
+                        return; // reader finished & all batches claimed
+                    }
+                    continue;
+                }
+                for (size_t i = 0; i < batch->count; ++i) {
+                    materialize(batch->recs[i].get(), line.get(), fields, tagsplit, tagsbuf,
+                                batch->rows[i]);
+                }
+                batches_parsed_.fetch_add(1, memory_order_acq_rel);
+                done_.enqueue(batch);
+            }
+        } catch (exception &exn) {
+            fail(exn);
         }
+    }
+
+    void materialize(bam1_t *rec, kstring_t *line, vector<char *> &fields,
+                     vector<char *> &tagsplit, OStringStream &tagsbuf, SamRow &row) {
         // Load the tab-split SAM line too, as some fields are easier to access that way
-        ret = sam_format1(hdr_, it.rec.get(), it.line.get());
+        line->l = 0;
+        int ret = sam_format1(hdr_, rec, line);
         if (ret < 0) {
             throw runtime_error("Corrupt SAM record; sam_format1() -> " + to_string(ret));
         }
-        split(it.line->s, '\t', back_inserter(it.fields));
-        if (it.fields.size() < 11) {
-            throw runtime_error("Corrupt SAM record; fields.size() = " +
-                                to_string(it.fields.size()));
+        fields.clear();
+        split(line->s, '\t', back_inserter(fields));
+        if (fields.size() < 11) {
+            throw runtime_error("Corrupt SAM record; fields.size() = " + to_string(fields.size()));
+        }
+
+        row.flag = rec->core.flag;
+        row.tid = rec->core.tid;
+        row.pos = rec->core.pos;
+        row.endpos = -1;
+        if (rec->core.pos >= 0) {
+            auto endpos = bam_endpos(rec);
+            if (endpos >= rec->core.pos) {
+                row.endpos = endpos;
+            }
+        }
+        row.mapq = rec->core.qual;
+        row.mtid = rec->core.mtid;
+        row.mpos = rec->core.mpos;
+        row.tlen = rec->core.isize;
+        row.qname.assign(bam_get_qname(rec));
+        const char *cigar = fields[5];
+        row.cigar.assign((*cigar && strcmp(cigar, "*")) ? cigar : "");
+        const char *seq = fields[9];
+        row.seq.assign((*seq && strcmp(seq, "*")) ? seq : "");
+        const char *qual = fields[10];
+        row.qual.assign((*qual && strcmp(qual, "*")) ? qual : "");
+
+        tagsbuf.Clear();
+        row.rg_id = write_tags_json(readgroups_, fields, tagsplit, tagsbuf);
+        row.tags_json.assign(tagsbuf.Get(), tagsbuf.Size());
+    }
+
+    // writer-side: release the current batch & take ownership of the one with the next serial,
+    // stashing any batches the workers completed out of order
+    bool next_batch() {
+        if (current_) {
+            recycle_.enqueue(current_);
+            current_ = nullptr;
+        }
+        auto t_spin = chrono::high_resolution_clock::now();
+        while (true) {
+            auto reordered = reorder_.find(next_serial_);
+            if (reordered != reorder_.end()) {
+                current_ = reordered->second;
+                reorder_.erase(reordered);
+                break;
+            }
+            if (stop_.load(memory_order_acquire)) {
+                lock_guard<mutex> lock(err_mutex_);
+                if (!errmsg_.empty()) {
+                    throw runtime_error(errmsg_);
+                }
+            }
+            long long total = batches_read_.load(memory_order_acquire);
+            if (total >= 0 && next_serial_ >= total) {
+                return false;
+            }
+            SamBatch *batch = nullptr;
+            if (done_.wait_dequeue_timed(batch, 100000)) {
+                if (batch->serial == next_serial_) {
+                    current_ = batch;
+                    break;
+                }
+                reorder_[batch->serial] = batch;
+            }
         }
-        // formulate tags JSON here on background thread
-        tagsbuf_.Clear();
-        it.rg_id = write_tags_json(readgroups_, it.fields, tagsparsebuf_, tagsbuf_);
-        it.tags_json = tagsbuf_.Get();
+        c_blocked_ += chrono::high_resolution_clock::now() - t_spin;
+        ++next_serial_;
         return true;
     }
+
+    void fail(const exception &exn) {
+        lock_guard<mutex> lock(err_mutex_);
+        if (errmsg_.empty()) {
+            errmsg_ = exn.what();
+            if (errmsg_.empty()) {
+                errmsg_ = "unknown error on pipeline thread";
+            }
+        }
+        stop_.store(true, memory_order_release);
+    }
+
+    // ~constant:
+    samFile *sam_;
+    sam_hdr_t *hdr_;
+    const map<string, int> &readgroups_;
+    size_t nworkers_;
+    vector<unique_ptr<SamBatch>> pool_;
+    unique_ptr<thread> reader_;
+    vector<thread> workers_;
+
+    // shared between threads:
+    moodycamel::BlockingConcurrentQueue<SamBatch *> recycle_, parse_, done_;
+    atomic<bool> stop_{false};
+    atomic<long long> batches_read_{-1}; // total batch count, set once the reader finishes
+    atomic<long long> batches_parsed_{0};
+    mutex err_mutex_;
+    string errmsg_;
+
+    // writer (consumer) thread only:
+    long long next_serial_ = 0, rows_ = 0;
+    map<long long, SamBatch *> reorder_;
+    SamBatch *current_ = nullptr;
+    size_t cursor_ = 0;
+    const SamRow *row_ = nullptr;
+    chrono::time_point<chrono::high_resolution_clock> t0_;
+    chrono::duration<double> c_blocked_ = chrono::duration<double>::zero();
 };
 
 void help() {
@@ -175,9 +382,14 @@ void help() {
          << "  --table-prefix PREFIX  prefix to the name of each table created" << '\n'
          << "  --no-gri               skip genomic range indexing" << '\n'
          << "  --no-qname-index       skip QNAME indexing" << '\n'
+         << "  --tags-binary-json     store tags_json in the binary JSON encoding, queryable with"
+         << '\n'
+         << "                         binary_json_extract() instead of json_extract()" << '\n'
          << "  --inner-page-KiB N     inner page size; one of {1,2,4,8,16,32,64}" << '\n'
          << "  --outer-page-KiB N     outer page size; one of {1,2,4,8,16,32,64}" << '\n'
          << "  -l,--level LEVEL       database compression level (-7 to 22, default 6)" << '\n'
+         << "  -@,--threads N         parser/encoder worker threads (default: all cores minus 2)"
+         << '\n'
          << "  -q,--quiet             suppress progress information on standard error" << '\n'
          << "  -h,--help              show this help message" << '\n'
          << '\n';
@@ -185,21 +397,23 @@ void help() {
 
 int main(int argc, char *argv[]) {
     string table_prefix, infilename, outfilename;
-    bool gri = true, qname_idx = true, progress = true;
-    int level = 6, inner_page_KiB = 16, outer_page_KiB = 32;
+    bool gri = true, qname_idx = true, progress = true, tags_binary_json = false;
+    int level = 6, inner_page_KiB = 16, outer_page_KiB = 32, threads = 0;
 
     static struct option long_options[] = {{"help", no_argument, 0, 'h'},
                                            {"quiet", no_argument, 0, 'q'},
                                            {"level", required_argument, 0, 'l'},
+                                           {"threads", required_argument, 0, '@'},
                                            {"inner-page-KiB", required_argument, 0, 'I'},
                                            {"outer-page-KiB", required_argument, 0, 'O'},
                                            {"table-prefix", required_argument, 0, 't'},
                                            {"no-gri", no_argument, 0, 'G'},
                                            {"no-qname-index", no_argument, 0, 'Q'},
+                                           {"tags-binary-json", no_argument, 0, 'B'},
                                            {0, 0, 0, 0}};
 
     int c;
-    while (-1 != (c = getopt_long(argc, argv, "hqQGl:t:I:O:", long_options, nullptr))) {
+    while (-1 != (c = getopt_long(argc, argv, "hqQGBl:t:I:O:@:", long_options, nullptr))) {
         switch (c) {
         case 'h':
             help();
@@ -213,6 +427,9 @@ int main(int argc, char *argv[]) {
         case 'Q':
             qname_idx = false;
             break;
+        case 'B':
+            tags_binary_json = true;
+            break;
         case 't':
             table_prefix = optarg;
             break;
@@ -224,6 +441,14 @@ int main(int argc, char *argv[]) {
                 return -1;
             }
             break;
+        case '@':
+            errno = 0;
+            threads = strtol(optarg, nullptr, 10);
+            if (errno || threads < 1 || threads > 4096) {
+                cerr << "sam_into_sqlite: invalid --threads" << endl;
+                return -1;
+            }
+            break;
         case 'I':
             errno = 0;
             inner_page_KiB = strtol(optarg, nullptr, 10);
@@ -337,7 +562,8 @@ int main(int argc, char *argv[]) {
                "reads(rowid), qname TEXT, seq TEXT, qual TEXT)";
         ddl += ";\nCREATE TABLE " + table_prefix +
                "reads_tags(rowid INTEGER PRIMARY KEY REFERENCES " + table_prefix +
-               "reads(rowid), tags_json TEXT NOT NULL DEFAULT '{}')";
+               (tags_binary_json ? "reads(rowid), tags_json BLOB NOT NULL)"
+                                 : "reads(rowid), tags_json TEXT NOT NULL DEFAULT '{}')");
 
         progress &&cerr << ddl << endl;
         db->exec(ddl);
@@ -349,45 +575,45 @@ int main(int argc, char *argv[]) {
                 "reads(flag,rid,pos,endpos,mapq,cigar,rnext,pnext,tlen,rg_id) VALUES(?,?,?,?,?,?,?,?,?,?)");
         SQLite::Statement insert_seqs(*db, "INSERT INTO " + table_prefix +
                                                "reads_seqs(rowid,qname,seq,qual) VALUES(?,?,?,?)");
+        // with --tags-binary-json, the extension's binary_json() SQL function encodes each row's
+        // tags on the way in; the pipeline workers keep producing JSON text either way
         SQLite::Statement insert_tags(*db, "INSERT INTO " + table_prefix +
-                                               "reads_tags(rowid,tags_json) VALUES(?,?)");
+                                               "reads_tags(rowid,tags_json) VALUES(?," +
+                                               (tags_binary_json ? "binary_json(?))" : "?)"));
 
-        // stream bam1_t records
+        // stream materialized rows off the parse/encode pipeline
         progress &&cerr << "inserting reads..." << endl;
-        SamReader reader(sam.get(), hdr.get(), readgroups, 256);
-        while (reader.next()) {
-            const SamItem &it = reader.item();
-            bam1_t *rec = it.rec.get();
-            auto &sam_fields = it.fields;
+        SamPipeline pipeline(sam.get(), hdr.get(), readgroups,
+                             threads > 0 ? threads : max(2, (int)thread::hardware_concurrency() - 2));
+        while (pipeline.next()) {
+            const SamRow &row = pipeline.item();
 
             insert_read.reset();
             insert_read.clearBindings();
 
-            insert_read.bind(1, rec->core.flag); // flag
-            if (rec->core.tid >= 0 && rec->core.tid < nSQ)
-                insert_read.bind(2, rec->core.tid); // rid
-            if (rec->core.pos >= 0) {
-                insert_read.bind(3, rec->core.pos); // pos
-                auto endpos = bam_endpos(rec);
-                if (endpos >= rec->core.pos) {
-                    insert_read.bind(4, endpos); // endpos
+            insert_read.bind(1, row.flag); // flag
+            if (row.tid >= 0 && row.tid < nSQ)
+                insert_read.bind(2, row.tid); // rid
+            if (row.pos >= 0) {
+                insert_read.bind(3, (long long)row.pos); // pos
+                if (row.endpos >= row.pos) {
+                    insert_read.bind(4, (long long)row.endpos); // endpos
                 }
             }
-            insert_read.bind(5, rec->core.qual); // mapq
+            insert_read.bind(5, row.mapq); // mapq
 
-            char *cigar = sam_fields[5];
-            if (*cigar && strcmp(cigar, "*"))
-                insert_read.bindNoCopy(6, cigar); // cigar
+            if (!row.cigar.empty())
+                insert_read.bindNoCopy(6, row.cigar); // cigar
 
-            if (rec->core.mtid >= 0 && rec->core.mtid <= nSQ)
-                insert_read.bind(7, rec->core.mtid); // rnext
-            if (rec->core.mpos >= 0)
-                insert_read.bind(8, rec->core.mpos); // pnext
-            if (rec->core.isize)
-                insert_read.bind(9, rec->core.isize); // tlen
+            if (row.mtid >= 0 && row.mtid <= nSQ)
+                insert_read.bind(7, row.mtid); // rnext
+            if (row.mpos >= 0)
+                insert_read.bind(8, (long long)row.mpos); // pnext
+            if (row.tlen)
+                insert_read.bind(9, (long long)row.tlen); // tlen
 
-            if (it.rg_id >= 0 && it.rg_id < readgroups.size()) {
-                insert_read.bind(10, it.rg_id); // rg_id
+            if (row.rg_id >= 0 && row.rg_id < readgroups.size()) {
+                insert_read.bind(10, row.rg_id); // rg_id
             }
 
             insert_read.exec();
@@ -396,21 +622,19 @@ int main(int argc, char *argv[]) {
             insert_seqs.reset();
             insert_seqs.clearBindings();
             insert_seqs.bind(1, rowid);
-            insert_seqs.bindNoCopy(2, bam_get_qname(rec)); // qname
-            char *seq = sam_fields[9];
-            if (*seq && strcmp(seq, "*"))
-                insert_seqs.bindNoCopy(3, seq); // seq
-            char *qual = sam_fields[10];
-            if (*qual && strcmp("*", qual))
-                insert_seqs.bindNoCopy(4, qual); // qual
+            insert_seqs.bindNoCopy(2, row.qname); // qname
+            if (!row.seq.empty())
+                insert_seqs.bindNoCopy(3, row.seq); // seq
+            if (!row.qual.empty())
+                insert_seqs.bindNoCopy(4, row.qual); // qual
             insert_seqs.exec();
 
             insert_tags.reset();
             insert_tags.bind(1, rowid);
-            insert_tags.bindNoCopy(2, it.tags_json.c_str()); // tags_json
+            insert_tags.bindNoCopy(2, row.tags_json); // tags_json
             insert_tags.exec();
         }
-        progress &&cerr << reader.log() << endl;
+        progress &&cerr << pipeline.log() << endl;
 
         // create indices
         if (gri) {
@@ -6,6 +6,7 @@
  *   - sample names go into a dimension table referred to by integer ID elsewhere
  * - array values are stored as JSON
  */
+#include "blockingconcurrentqueue.h"
 #include "common.hpp"
 #include <cmath>
 #include <functional>
@@ -40,6 +41,53 @@ vector<map<string, string>> extract_hrecs(bcf_hdr_t *hdr, const char *key,
     return ans;
 }
 
+// DDL for the genotypes table alone; also used to initialize shard databases for parallel load
+string genotypesDDL(const string &table_prefix, vector<map<string, string>> &format_hrecs,
+                    int ploidy, bool genotypes_without_rowid) {
+    OStringStream out;
+    out << "CREATE TABLE " << table_prefix
+        << "genotypes (variant_rowid INTEGER NOT NULL REFERENCES " << table_prefix
+        << "variants(variant_rowid), sample_id INTEGER NOT NULL REFERENCES " << table_prefix
+        << "samples(sample_id)";
+
+    // FORMAT columns
+    for (auto &hrec : format_hrecs) {
+        if (hrec["ID"] == "GT") {
+            for (int i = 1; i <= ploidy; ++i) {
+                out << "\n, GT" << to_string(i) << " INTEGER  --  allele called on homolog "
+                    << to_string(i);
+            }
+            if (ploidy > 1) {
+                out << "\n, GT_ploidy INTEGER  --  number of homologs called, negated if calls are phased";
+            }
+        } else {
+            out << "\n, " << hrec["ID"];
+            if (hrec["Number"] != "1" && (hrec["Type"] == "Integer" || hrec["Type"] == "Float")) {
+                out << "_jsarray TEXT DEFAULT '[]'";
+            } else if (hrec["Type"] == "Integer") {
+                out << " INTEGER";
+            } else if (hrec["Type"] == "Float") {
+                out << " REAL";
+            } else {
+                out << " TEXT";
+            }
+
+            // add SQL comment with original metadata
+            out << "  --  "
+                << "Number=" << hrec["Number"] << ",Type=" << hrec["Type"];
+            auto desc = hrec.find("Description");
+            if (desc != hrec.end() && !desc->second.empty()) {
+                out << ",Description=" << desc->second;
+            }
+        }
+    }
+    out << "\n, PRIMARY KEY (variant_rowid, sample_id))";
+    if (genotypes_without_rowid) {
+        out << " WITHOUT ROWID";
+    }
+    return string(out.Get());
+}
+
 string schemaDDL(const string &table_prefix, vector<map<string, string>> &info_hrecs,
                  vector<map<string, string>> &format_hrecs, int ploidy,
                  bool genotypes_without_rowid) {
@@ -80,47 +128,7 @@ string schemaDDL(const string &table_prefix, vector<map<string, string>> &info_h
         // TODO: include metadata from SAMPLE header lines
         out << ";\nCREATE TABLE " << table_prefix
             << "samples (sample_id INTEGER NOT NULL PRIMARY KEY, sample_name TEXT NOT NULL)";
-        out << ";\nCREATE TABLE " << table_prefix
-            << "genotypes (variant_rowid INTEGER NOT NULL REFERENCES " << table_prefix
-            << "variants(variant_rowid), sample_id INTEGER NOT NULL REFERENCES " << table_prefix
-            << "samples(sample_id)";
-
-        // FORMAT columns
-        for (auto &hrec : format_hrecs) {
-            if (hrec["ID"] == "GT") {
-                for (int i = 1; i <= ploidy; ++i) {
-                    out << "\n, GT" << to_string(i) << " INTEGER  --  allele called on homolog "
-                        << to_string(i);
-                }
-                if (ploidy > 1) {
-                    out << "\n, GT_ploidy INTEGER  --  number of homologs called, negated if calls are phased";
-                }
-            } else {
-                out << "\n, " << hrec["ID"];
-                if (hrec["Number"] != "1" &&
-                    (hrec["Type"] == "Integer" || hrec["Type"] == "Float")) {
-                    out << "_jsarray TEXT DEFAULT '[]'";
-                } else if (hrec["Type"] == "Integer") {
-                    out << " INTEGER";
-                } else if (hrec["Type"] == "Float") {
-                    out << " REAL";
-                } else {
-                    out << " TEXT";
-                }
-
-                // add SQL comment with original metadata
-                out << "  --  "
-                    << "Number=" << hrec["Number"] << ",Type=" << hrec["Type"];
-                auto desc = hrec.find("Description");
-                if (desc != hrec.end() && !desc->second.empty()) {
-                    out << ",Description=" << desc->second;
-                }
-            }
-        }
-        out << "\n, PRIMARY KEY (variant_rowid, sample_id))";
-        if (genotypes_without_rowid) {
-            out << " WITHOUT ROWID";
-        }
+        out << ";\n" << genotypesDDL(table_prefix, format_hrecs, ploidy, genotypes_without_rowid);
     }
 
     return string(out.Get());
@@ -539,6 +547,165 @@ class BCFReader : public BackgroundProducer<shared_ptr<bcf1_t>> {
     }
 };
 
+// Sharded parallel genotype ingestion: each worker thread opens its own connection to a shard
+// database file -- with its own zstd_vfs compression pipeline -- and drains a queue of
+// (variant_rowid, bcf1_t) work, running the same insert_genotypes() path as the serial load.
+// Variants are dealt round-robin so the shards stay balanced and each stays sorted by
+// variant_rowid. After the variant stream ends, merge() ATTACHes the shards to the main database
+// and unions them into the genotypes table, then deletes the shard files.
+class GenotypeShardPool {
+    struct Work {
+        sqlite3_int64 variant_rowid = -1;
+        shared_ptr<bcf1_t> rec;
+    };
+    // bound on dispatched-but-uninserted variants, to limit memory held in bcf1_t buffers
+    static const long long MAX_IN_FLIGHT = 64;
+
+  public:
+    GenotypeShardPool(const string &outfilename, const string &config_json,
+                      const string &table_prefix, bcf_hdr_t *hdr,
+                      vector<map<string, string>> &format_hrecs, int ploidy,
+                      const string &genotypes_ddl, size_t nshards, bool progress)
+        : outfilename_(outfilename), config_json_(config_json), table_prefix_(table_prefix),
+          hdr_(hdr), format_hrecs_(format_hrecs), ploidy_(ploidy), genotypes_ddl_(genotypes_ddl),
+          progress_(progress), queues_(nshards), enqueued_(nshards) {
+        for (size_t i = 0; i < nshards; ++i) {
+            enqueued_[i] = 0;
+            workers_.emplace_back([this, i]() { this->worker(i); });
+        }
+    }
+
+    ~GenotypeShardPool() {
+        stop_.store(true, memory_order_relaxed);
+        join();
+    }
+
+    // dispatch one variant's genotype rows to a shard (round-robin); takes ownership of rec
+    void enqueue(sqlite3_int64 variant_rowid, shared_ptr<bcf1_t> rec) {
+        long long spin = 0;
+        while (dispatched_ - completed_.load(memory_order_acquire) >= MAX_IN_FLIGHT) {
+            check_error();
+            this_thread::sleep_for(chrono::nanoseconds(10000 + 990000 * min(spin++, 100LL) / 100));
+        }
+        check_error();
+        Work w;
+        w.variant_rowid = variant_rowid;
+        w.rec = move(rec);
+        size_t shard = dispatched_++ % queues_.size();
+        enqueued_[shard].fetch_add(1, memory_order_release);
+        queues_[shard].enqueue(move(w));
+    }
+
+    // signal end of the variant stream & await the workers (committing the shard transactions)
+    void finish() {
+        finished_.store(true, memory_order_release);
+        join();
+        check_error();
+    }
+
+    // ATTACH the shard databases & union their rows into the main genotypes table; to be called
+    // after finish() and outside of any transaction on db
+    void merge(SQLite::Database &db) {
+        progress_ &&cerr << "merging " << queues_.size() << " genotype shard(s)..." << endl;
+        for (size_t i = 0; i < queues_.size(); ++i) {
+            string attach_sql =
+                GenomicSQLiteAttachSQL(shardfile(i), "genotype_shard" + to_string(i), config_json_);
+            _DBG << attach_sql << endl;
+            db.exec(attach_sql);
+        }
+        SQLite::Transaction txn(db);
+        for (size_t i = 0; i < queues_.size(); ++i) {
+            db.exec("INSERT INTO " + table_prefix_ + "genotypes SELECT * FROM genotype_shard" +
+                    to_string(i) + "." + table_prefix_ + "genotypes");
+        }
+        txn.commit();
+        for (size_t i = 0; i < queues_.size(); ++i) {
+            db.exec("DETACH genotype_shard" + to_string(i));
+            unlink(shardfile(i).c_str());
+        }
+    }
+
+  private:
+    string shardfile(size_t i) const {
+        return outfilename_ + ".genotype_shard" + to_string(i);
+    }
+
+    void worker(size_t i) {
+        try {
+            auto db = GenomicSQLiteOpen(
+                shardfile(i), SQLITE_OPEN_CREATE | SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX,
+                config_json_);
+            db->exec(genotypes_ddl_);
+            SQLite::Transaction txn(*db);
+            auto stmt = prepare_insert_genotype(table_prefix_, format_hrecs_, ploidy_, *db);
+
+            long long processed = 0;
+            Work w;
+            while (!stop_.load(memory_order_relaxed)) {
+                if (!queues_[i].wait_dequeue_timed(w, 100000)) {
+                    if (finished_.load(memory_order_acquire) &&
+                        processed >= enqueued_[i].load(memory_order_acquire)) {
+                        break; // stream over & this shard's queue fully drained
+                    }
+                    continue;
+                }
+                insert_genotypes(hdr_, w.rec.get(), format_hrecs_, ploidy_, w.variant_rowid,
+                                 *stmt);
+                w.rec.reset();
+                ++processed;
+                completed_.fetch_add(1, memory_order_acq_rel);
+            }
+            if (!stop_.load(memory_order_relaxed)) {
+                txn.commit();
+            }
+        } catch (exception &exn) {
+            lock_guard<mutex> lock(err_mutex_);
+            if (errmsg_.empty()) {
+                errmsg_ = exn.what();
+                if (errmsg_.empty()) {
+                    errmsg_ = "unknown error on genotype shard worker";
+                }
+            }
+            stop_.store(true, memory_order_release);
+        }
+    }
+
+    void join() {
+        for (auto &w : workers_) {
+            if (w.joinable()) {
+                w.join();
+            }
+        }
+    }
+
+    void check_error() {
+        if (stop_.load(memory_order_acquire)) {
+            lock_guard<mutex> lock(err_mutex_);
+            throw runtime_error(errmsg_.empty() ? "genotype shard worker stopped" : errmsg_);
+        }
+    }
+
+    // ~constant:
+    string outfilename_, config_json_, table_prefix_;
+    bcf_hdr_t *hdr_;
+    vector<map<string, string>> &format_hrecs_;
+    int ploidy_;
+    string genotypes_ddl_;
+    bool progress_;
+    vector<thread> workers_;
+
+    // shared between threads:
+    vector<moodycamel::BlockingConcurrentQueue<Work>> queues_;
+    vector<atomic<long long>> enqueued_;
+    atomic<long long> completed_{0};
+    atomic<bool> stop_{false}, finished_{false};
+    mutex err_mutex_;
+    string errmsg_;
+
+    // main (dispatching) thread only:
+    long long dispatched_ = 0;
+};
+
 void help() {
     cout
         << "vcf_into_sqlite: import .vcf, .vcf.gz, or .bcf into GenomicSQLite database with all fields unpacked"
@@ -551,6 +718,8 @@ void help() {
         << "  --ploidy N                 set max ploidy => # GT columns (default 2)" << '\n'
         << "  --genotypes-without-rowid  make the genotypes table WITHOUT ROWID (advantageous if the FORMAT fields aren't too large)"
         << '\n'
+        << "  --genotype-shards N        insert genotypes through N parallel shard databases, merged at the end (default 1 = serial)"
+        << '\n'
         << "  --no-gri                   skip genomic range indexing" << '\n'
         << "  --inner-page-KiB N         inner page size; one of {1,2,4,8,16,32,64}" << '\n'
         << "  --outer-page-KiB N         outer page size; one of {1,2,4,8,16,32,64}" << '\n'
@@ -563,7 +732,7 @@ void help() {
 int main(int argc, char *argv[]) {
     string table_prefix, infilename, outfilename;
     bool gri = true, progress = true, genotypes_without_rowid = false;
-    int level = 6, ploidy = 2, inner_page_KiB = 16, outer_page_KiB = 32;
+    int level = 6, ploidy = 2, inner_page_KiB = 16, outer_page_KiB = 32, genotype_shards = 1;
 
     static struct option long_options[] = {{"help", no_argument, 0, 'h'},
                                            {"quiet", no_argument, 0, 'q'},
@@ -572,12 +741,13 @@ int main(int argc, char *argv[]) {
                                            {"level", required_argument, 0, 'l'},
                                            {"ploidy", required_argument, 0, 'p'},
                                            {"genotypes-without-rowid", no_argument, 0, 'R'},
+                                           {"genotype-shards", required_argument, 0, 'S'},
                                            {"table-prefix", required_argument, 0, 't'},
                                            {"no-gri", no_argument, 0, 'G'},
                                            {0, 0, 0, 0}};
 
     int c;
-    while (-1 != (c = getopt_long(argc, argv, "hqGRl:t:p:", long_options, nullptr))) {
+    while (-1 != (c = getopt_long(argc, argv, "hqGRl:t:p:S:", long_options, nullptr))) {
         switch (c) {
         case 'h':
             help();
@@ -591,6 +761,14 @@ int main(int argc, char *argv[]) {
         case 'R':
             genotypes_without_rowid = true;
             break;
+        case 'S':
+            errno = 0;
+            genotype_shards = strtol(optarg, nullptr, 10);
+            if (errno || genotype_shards < 1 || genotype_shards > 256) {
+                cerr << "vcf_into_sqlite: invalid --genotype-shards" << endl;
+                return -1;
+            }
+            break;
         case 't':
             table_prefix = optarg;
             break;
@@ -731,6 +909,13 @@ int main(int argc, char *argv[]) {
         // process VCF records
         auto insert_variant_stmt = prepare_insert_variant(table_prefix, info_hrecs, *db);
         unique_ptr<SQLite::Statement> insert_genotype_stmt;
+        unique_ptr<GenotypeShardPool> shard_pool;
+        if (!format_hrecs.empty() && genotype_shards > 1) {
+            shard_pool.reset(new GenotypeShardPool(
+                outfilename, config_json, table_prefix, hdr.get(), format_hrecs, ploidy,
+                genotypesDDL(table_prefix, format_hrecs, ploidy, genotypes_without_rowid),
+                genotype_shards, progress));
+        }
         progress &&cerr << "inserting variants"
                         << (format_hrecs.empty() ? "..." : " & genotypes...") << endl;
 
@@ -741,18 +926,29 @@ int main(int argc, char *argv[]) {
             try {
                 insert_variant(hdr.get(), rec, info_hrecs, *insert_variant_stmt);
                 if (!format_hrecs.empty()) {
-                    if (!insert_genotype_stmt) {
-                        insert_genotype_stmt =
-                            prepare_insert_genotype(table_prefix, format_hrecs, ploidy, *db);
+                    if (shard_pool) {
+                        // move the bcf1_t off the producer's ring so the shard worker can own it;
+                        // BCFReader::Produce replaces the vacated slot
+                        shared_ptr<bcf1_t> taken;
+                        taken.swap(reader.item_mut());
+                        shard_pool->enqueue(db->getLastInsertRowid(), move(taken));
+                    } else {
+                        if (!insert_genotype_stmt) {
+                            insert_genotype_stmt =
+                                prepare_insert_genotype(table_prefix, format_hrecs, ploidy, *db);
+                        }
+                        insert_genotypes(hdr.get(), rec, format_hrecs, ploidy,
+                                         db->getLastInsertRowid(), *insert_genotype_stmt);
                     }
-                    insert_genotypes(hdr.get(), rec, format_hrecs, ploidy, db->getLastInsertRowid(),
-                                     *insert_genotype_stmt);
                 }
             } catch (exception &exn) {
                 reader.abort();
                 throw exn;
             }
         }
+        if (shard_pool) {
+            shard_pool->finish();
+        }
         progress &&cerr << reader.log() << endl;
 
         // create GRI
@@ -766,6 +962,11 @@ int main(int argc, char *argv[]) {
 
         progress &&cerr << "COMMIT" << endl;
         txn.commit();
+
+        // union the genotype shards into the main database (ATTACH requires no open transaction)
+        if (shard_pool) {
+            shard_pool->merge(*db);
+        }
     } catch (exception &exn) {
         cerr << "vcf_into_sqlite: " << exn.what() << '\n';
         return 1;
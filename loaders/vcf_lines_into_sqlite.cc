@@ -3,20 +3,24 @@
  * text line alongside bare-essential columns for genomic range indexing (CHROM,POS,rlen). The
  * header is jammed into a row with null positions.
  */
+#include "blockingconcurrentqueue.h"
 #include "common.hpp"
 #include <fstream>
 #include <getopt.h>
+#include <map>
+#include <mutex>
 #include <unistd.h>
 #include <vector>
+#include <zlib.h>
 
-void InsertLine(const string &line, SQLite::Statement &stmt) {
+void InsertLine(const char *line, SQLite::Statement &stmt) {
     stmt.reset();
 
     string line2(line);
     vector<char *> fields;
     split(line2, '\t', back_inserter(fields), 9);
     if (fields.size() < 8) {
-        throw runtime_error("invalid VCF: " + line);
+        throw runtime_error("invalid VCF: " + string(line));
     }
 
     // CHROM
@@ -48,17 +52,386 @@ void InsertLine(const string &line, SQLite::Statement &stmt) {
     stmt.exec();
 }
 
+// Source of input VCF text lines, either plain text consumed serially or BGZF decompressed
+// block-parallel (below)
+class VcfLineSource {
+  public:
+    virtual ~VcfLineSource() {}
+    // advance to the next line & return true, or return false at successful end of input, or
+    // throw an exception
+    virtual bool next() = 0;
+    // current line; defined only after next() returned true
+    virtual const char *line() = 0;
+    virtual string log() { return string(); }
+};
+
+class SerialLines : public VcfLineSource {
+    string buf_;
+
+  public:
+    bool next() override {
+        if (!getline(cin, buf_)) {
+            if (!cin.eof() || cin.bad()) {
+                throw runtime_error("input read error");
+            }
+            return false;
+        }
+        return true;
+    }
+    const char *line() override { return buf_.c_str(); }
+};
+
+// Batch of BGZF blocks flowing reader -> inflate worker -> consumer. Batches are recycled through
+// the pipeline so the buffers get reused instead of reallocated.
+struct BgzfBatch {
+    long long serial = -1;
+    // compressed: concatenated raw-deflate block payloads, located by blocks[]
+    struct BlockRef {
+        size_t ofs = 0, len = 0;
+        uint32_t isize = 0; // uncompressed size from the block footer
+    };
+    vector<uint8_t> compressed;
+    vector<BlockRef> blocks;
+    // filled out by an inflate worker:
+    vector<char> text;    // decompressed batch text, NUL-split in place
+    vector<char *> lines; // the complete lines lying strictly between the first & last newline
+    string head, tail;    // partial-line fragments before the first / after the last newline
+    bool has_newline = false;
+};
+
+// Block-parallel BGZF reader, patterned after SamPipeline in sam_into_sqlite.cc. One reader
+// thread carves independent BGZF blocks off the (inherently serial) input stream into batches;
+// worker threads take batches off a concurrent queue, inflate the blocks, and split lines
+// zero-copy within each decompressed batch; the consumer thread receives completed batches
+// restored to original stream order and stitches the partial lines carried across batch
+// boundaries.
+class BgzfLinesPipeline : public VcfLineSource {
+    static const size_t BLOCKS_PER_BATCH = 64; // <= 4 MiB of text per batch
+
+  public:
+    BgzfLinesPipeline(size_t workers) : nworkers_(max(size_t(1), workers)) {}
+
+    ~BgzfLinesPipeline() {
+        stop_.store(true, memory_order_relaxed);
+        if (reader_) {
+            reader_->join();
+        }
+        for (auto &w : workers_) {
+            w.join();
+        }
+    }
+
+    bool next() override {
+        if (!reader_) {
+            start();
+        }
+        while (true) {
+            if (current_ && cursor_ < current_->lines.size()) {
+                line_ = current_->lines[cursor_++];
+                ++rows_;
+                return true;
+            }
+            if (!next_batch()) {
+                if (!carry_.empty()) {
+                    // final line, without trailing newline
+                    synth_.swap(carry_);
+                    carry_.clear();
+                    line_ = synth_.c_str();
+                    ++rows_;
+                    return true;
+                }
+                return false;
+            }
+            if (!current_->has_newline) {
+                // batch lies entirely within one line
+                carry_ += current_->head;
+                continue;
+            }
+            // the first newline in the batch completes the line carried over from its predecessors
+            synth_.assign(carry_);
+            synth_ += current_->head;
+            carry_.assign(current_->tail);
+            cursor_ = 0;
+            line_ = synth_.c_str();
+            ++rows_;
+            return true;
+        }
+    }
+
+    const char *line() override { return line_; }
+
+    string log() override {
+        chrono::duration<double> elapsed = chrono::high_resolution_clock::now() - t0_;
+        OStringStream ans;
+        ans << to_string(rows_) << " line(s) decompressed & split in " << to_string(elapsed.count())
+            << "s with " << to_string(nworkers_) << " worker(s)"
+            << "; consumer blocked for " << to_string(c_blocked_.count()) << "s";
+        return string(ans.Get());
+    }
+
+  private:
+    void start() {
+        t0_ = chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < nworkers_ * 3 + 4; ++i) {
+            pool_.emplace_back(new BgzfBatch);
+            recycle_.enqueue(pool_.back().get());
+        }
+        reader_.reset(new thread([this]() { this->reader_thread(); }));
+        for (size_t i = 0; i < nworkers_; ++i) {
+            workers_.emplace_back([this]() { this->worker_thread(); });
+        }
+    }
+
+    // read one BGZF block off cin, appending its deflate payload to batch.compressed; returns
+    // false at clean EOF
+    bool read_block(BgzfBatch &batch) {
+        uint8_t hdr[12];
+        cin.read((char *)hdr, sizeof(hdr));
+        if (cin.gcount() == 0 && cin.eof()) {
+            return false;
+        }
+        if (cin.gcount() != sizeof(hdr) || hdr[0] != 0x1f || hdr[1] != 0x8b || hdr[2] != 8) {
+            throw runtime_error("malformed BGZF block header");
+        }
+        if (!(hdr[3] & 4)) {
+            throw runtime_error(
+                "gzipped input isn't BGZF (from bgzip); decompress it upstream instead");
+        }
+        // scan the gzip extra field for the BC subfield giving the total block size
+        size_t xlen = hdr[10] | (size_t(hdr[11]) << 8);
+        extra_.resize(xlen);
+        if (!cin.read((char *)extra_.data(), xlen)) {
+            throw runtime_error("truncated BGZF block");
+        }
+        size_t bsize = 0;
+        bool found = false;
+        for (size_t i = 0; i + 4 <= xlen;) {
+            size_t slen = extra_[i + 2] | (size_t(extra_[i + 3]) << 8);
+            if (extra_[i] == 'B' && extra_[i + 1] == 'C' && slen == 2 && i + 6 <= xlen) {
+                bsize = (extra_[i + 4] | (size_t(extra_[i + 5]) << 8)) + 1;
+                found = true;
+            }
+            i += 4 + slen;
+        }
+        if (!found) {
+            throw runtime_error(
+                "gzipped input isn't BGZF (from bgzip); decompress it upstream instead");
+        }
+        if (bsize < sizeof(hdr) + xlen + 8 + 2) {
+            throw runtime_error("malformed BGZF block header");
+        }
+        BgzfBatch::BlockRef ref;
+        ref.ofs = batch.compressed.size();
+        ref.len = bsize - sizeof(hdr) - xlen - 8;
+        batch.compressed.resize(ref.ofs + ref.len);
+        uint8_t footer[8];
+        if (!cin.read((char *)&batch.compressed[ref.ofs], ref.len) ||
+            !cin.read((char *)footer, sizeof(footer))) {
+            throw runtime_error("truncated BGZF block");
+        }
+        ref.isize = footer[4] | (uint32_t(footer[5]) << 8) | (uint32_t(footer[6]) << 16) |
+                    (uint32_t(footer[7]) << 24);
+        batch.blocks.push_back(ref);
+        return true;
+    }
+
+    void reader_thread() {
+        long long serial = 0;
+        try {
+            bool more = true;
+            while (more && !stop_.load(memory_order_relaxed)) {
+                BgzfBatch *batch = nullptr;
+                while (!recycle_.wait_dequeue_timed(batch, 100000)) {
+                    if (stop_.load(memory_order_relaxed)) {
+                        batches_read_.store(serial, memory_order_release);
+                        return;
+                    }
+                }
+                batch->serial = serial;
+                batch->compressed.clear();
+                batch->blocks.clear();
+                while (batch->blocks.size() < BLOCKS_PER_BATCH && (more = read_block(*batch))) {
+                }
+                if (!batch->blocks.empty()) {
+                    ++serial;
+                    inflate_.enqueue(batch);
+                } else {
+                    recycle_.enqueue(batch);
+                }
+            }
+        } catch (exception &exn) {
+            fail(exn);
+        }
+        batches_read_.store(serial, memory_order_release);
+    }
+
+    void worker_thread() {
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        if (inflateInit2(&zs, -15) != Z_OK) { // raw deflate
+            fail(runtime_error("inflateInit2() failed"));
+            return;
+        }
+        try {
+            while (!stop_.load(memory_order_relaxed)) {
+                BgzfBatch *batch = nullptr;
+                if (!inflate_.wait_dequeue_timed(batch, 100000)) {
+                    long long total = batches_read_.load(memory_order_acquire);
+                    if (total >= 0 && batches_inflated_.load(memory_order_acquire) >= total) {
+                        break; // reader finished & all batches claimed
+                    }
+                    continue;
+                }
+                inflate_batch(zs, *batch);
+                batches_inflated_.fetch_add(1, memory_order_acq_rel);
+                done_.enqueue(batch);
+            }
+        } catch (exception &exn) {
+            fail(exn);
+        }
+        inflateEnd(&zs);
+    }
+
+    void inflate_batch(z_stream &zs, BgzfBatch &batch) {
+        size_t total = 0;
+        for (const auto &ref : batch.blocks) {
+            total += ref.isize;
+        }
+        batch.text.resize(total);
+        size_t out_ofs = 0;
+        for (const auto &ref : batch.blocks) {
+            if (ref.isize) {
+                if (inflateReset(&zs) != Z_OK) {
+                    throw runtime_error("inflateReset() failed");
+                }
+                zs.next_in = &batch.compressed[ref.ofs];
+                zs.avail_in = ref.len;
+                zs.next_out = (Bytef *)&batch.text[out_ofs];
+                zs.avail_out = ref.isize;
+                if (inflate(&zs, Z_FINISH) != Z_STREAM_END || zs.avail_out != 0) {
+                    throw runtime_error("corrupt BGZF block");
+                }
+                out_ofs += ref.isize;
+            }
+        }
+        // zero-copy line split: complete lines lie strictly between the first & last newline;
+        // the fragments outside them await stitching with the neighboring batches
+        batch.lines.clear();
+        char *first_nl = (char *)memchr(batch.text.data(), '\n', batch.text.size());
+        if (!first_nl) {
+            batch.has_newline = false;
+            batch.head.assign(batch.text.data(), batch.text.size());
+            batch.tail.clear();
+            return;
+        }
+        batch.has_newline = true;
+        batch.head.assign(batch.text.data(), first_nl - batch.text.data());
+        size_t last = batch.text.size();
+        while (batch.text[last - 1] != '\n') {
+            --last;
+        }
+        batch.tail.assign(&batch.text[last], batch.text.size() - last);
+        if (&batch.text[last - 1] > first_nl) {
+            batch.text[last - 1] = 0;
+            split(first_nl + 1, '\n', back_inserter(batch.lines));
+        }
+    }
+
+    // consumer-side: release the current batch & take ownership of the one with the next serial,
+    // stashing any batches the workers completed out of order
+    bool next_batch() {
+        if (current_) {
+            recycle_.enqueue(current_);
+            current_ = nullptr;
+        }
+        auto t_spin = chrono::high_resolution_clock::now();
+        while (true) {
+            auto reordered = reorder_.find(next_serial_);
+            if (reordered != reorder_.end()) {
+                current_ = reordered->second;
+                reorder_.erase(reordered);
+                break;
+            }
+            if (stop_.load(memory_order_acquire)) {
+                lock_guard<mutex> lock(err_mutex_);
+                if (!errmsg_.empty()) {
+                    throw runtime_error(errmsg_);
+                }
+            }
+            long long total = batches_read_.load(memory_order_acquire);
+            if (total >= 0 && next_serial_ >= total) {
+                return false;
+            }
+            BgzfBatch *batch = nullptr;
+            if (done_.wait_dequeue_timed(batch, 100000)) {
+                if (batch->serial == next_serial_) {
+                    current_ = batch;
+                    break;
+                }
+                reorder_[batch->serial] = batch;
+            }
+        }
+        c_blocked_ += chrono::high_resolution_clock::now() - t_spin;
+        ++next_serial_;
+        return true;
+    }
+
+    void fail(const exception &exn) {
+        lock_guard<mutex> lock(err_mutex_);
+        if (errmsg_.empty()) {
+            errmsg_ = exn.what();
+            if (errmsg_.empty()) {
+                errmsg_ = "unknown error on pipeline thread";
+            }
+        }
+        stop_.store(true, memory_order_release);
+    }
+
+    // ~constant:
+    size_t nworkers_;
+    vector<unique_ptr<BgzfBatch>> pool_;
+    unique_ptr<thread> reader_;
+    vector<thread> workers_;
+
+    // reader thread only:
+    vector<uint8_t> extra_;
+
+    // shared between threads:
+    moodycamel::BlockingConcurrentQueue<BgzfBatch *> recycle_, inflate_, done_;
+    atomic<bool> stop_{false};
+    atomic<long long> batches_read_{-1}; // total batch count, set once the reader finishes
+    atomic<long long> batches_inflated_{0};
+    mutex err_mutex_;
+    string errmsg_;
+
+    // consumer thread only:
+    long long next_serial_ = 0, rows_ = 0;
+    map<long long, BgzfBatch *> reorder_;
+    BgzfBatch *current_ = nullptr;
+    size_t cursor_ = 0;
+    string carry_, synth_;
+    const char *line_ = nullptr;
+    chrono::time_point<chrono::high_resolution_clock> t0_;
+    chrono::duration<double> c_blocked_ = chrono::duration<double>::zero();
+};
+
 void help() {
     cout
         << "vcf_lines_into_sqlite: import .vcf, .vcf.gz, or .bcf lines into simple GenomicSQLite table"
         << '\n'
         << GIT_REVISION << "   " << __DATE__ << '\n'
         << '\n'
-        << "bgzip -dc in.vcf.gz | vcf_lines_into_sqlite [options] out.db" << '\n'
+        << "vcf_lines_into_sqlite [options] out.db < in.vcf.gz" << '\n'
+        << "Standard input may be bgzip-compressed VCF, decompressed block-parallel across worker"
+        << '\n'
+        << "threads, or plain VCF text (e.g. bgzip -dc in.vcf.gz | vcf_lines_into_sqlite out.db)."
+        << '\n'
         << "Options: " << '\n'
         << "  --table NAME           table name (default: vcf_lines)" << '\n'
         << "  --no-gri               skip genomic range indexing" << '\n'
         << "  -l,--level LEVEL       database compression level (-7 to 22, default 6)" << '\n'
+        << "  -@,--threads N         BGZF decompression worker threads (default: all cores minus 2)"
+        << '\n'
         << "  -q,--quiet             suppress progress information on standard error" << '\n'
         << "  -h,--help              show this help message" << '\n'
         << '\n';
@@ -67,15 +440,16 @@ void help() {
 int main(int argc, char *argv[]) {
     string table("vcf_lines"), outfilename;
     bool gri = true, progress = true;
-    int level = 6;
+    int level = 6, threads = 0;
 
     static struct option long_options[] = {
         {"help", no_argument, 0, 'h'},        {"quiet", no_argument, 0, 'q'},
-        {"level", required_argument, 0, 'l'}, {"table", required_argument, 0, 't'},
-        {"no-gri", no_argument, 0, 'G'},      {0, 0, 0, 0}};
+        {"level", required_argument, 0, 'l'}, {"threads", required_argument, 0, '@'},
+        {"table", required_argument, 0, 't'}, {"no-gri", no_argument, 0, 'G'},
+        {0, 0, 0, 0}};
 
     int c;
-    while (-1 != (c = getopt_long(argc, argv, "hqGl:t:", long_options, nullptr))) {
+    while (-1 != (c = getopt_long(argc, argv, "hqGl:t:@:", long_options, nullptr))) {
         switch (c) {
         case 'h':
             help();
@@ -97,6 +471,14 @@ int main(int argc, char *argv[]) {
                 return -1;
             }
             break;
+        case '@':
+            errno = 0;
+            threads = strtol(optarg, nullptr, 10);
+            if (errno || threads < 1 || threads > 4096) {
+                cerr << "vcf_lines_into_sqlite: invalid --threads" << endl;
+                return -1;
+            }
+            break;
         default:
             help();
             return -1;
@@ -117,22 +499,20 @@ int main(int argc, char *argv[]) {
     cin.tie(nullptr);
 
     try {
-        OStringStream hdr;
-        string input_line;
-        while (getline(cin, input_line)) {
-            if (input_line.empty()) {
-                throw runtime_error("vcf_lines_into_sqlite: unexpected empty line");
-                return 1;
-            }
-            if (input_line[0] == '#') {
-                hdr << input_line << '\n';
-            } else {
-                break;
-            }
+        // sniff the input: gzip magic byte => BGZF block-parallel mode, otherwise plain text
+        unique_ptr<VcfLineSource> src;
+        if (cin.peek() == 0x1f) {
+            src.reset(new BgzfLinesPipeline(
+                threads > 0 ? threads : max(2, (int)thread::hardware_concurrency() - 2)));
+        } else {
+            src.reset(new SerialLines());
         }
-        if (cin.bad()) {
-            throw runtime_error("vcf_lines_into_sqlite: input read error");
-            return 1;
+
+        OStringStream hdr;
+        bool have_line = src->next();
+        while (have_line && src->line()[0] == '#') {
+            hdr << src->line() << '\n';
+            have_line = src->next();
         }
 
         // open output database
@@ -157,15 +537,21 @@ int main(int argc, char *argv[]) {
         stmt_insert.exec();
 
         int count = 0;
-        do {
-            InsertLine(input_line, stmt_insert);
+        while (have_line) {
+            if (!src->line()[0]) {
+                throw runtime_error("vcf_lines_into_sqlite: unexpected empty line");
+            }
+            InsertLine(src->line(), stmt_insert);
             ++count;
-        } while (getline(cin, input_line));
-        if (!cin.eof() || cin.bad()) {
-            throw runtime_error("vcf_lines_into_sqlite: input read error");
-            return 1;
+            have_line = src->next();
         }
         progress &&cerr << "inserted " << count << " lines" << endl;
+        if (progress) {
+            string src_log = src->log();
+            if (!src_log.empty()) {
+                cerr << src_log << endl;
+            }
+        }
 
         // create GRI
         if (gri) {
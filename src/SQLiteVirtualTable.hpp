@@ -56,6 +56,29 @@ class SQLiteVirtualTableCursor {
 
     SQLiteVirtualTableCursor(SQLiteVirtualTableCursor &rhs) = delete;
 
+    // Iterate the value(s) of a Filter() argument: if BestIndexTVF() opted its hidden column into
+    // SQLite's batched IN-operator protocol (per the idxNum bit for its argument position), invoke
+    // f once per value in the IN list; otherwise invoke f exactly once with the scalar argument.
+    // f returns an SQLite error code; iteration stops at the first != SQLITE_OK.
+    template <typename F>
+    int ForEachFilterValue(int idxNum, int argpos, sqlite3_value *arg, F f) {
+#if SQLITE_VERSION_NUMBER >= 3038000
+        if ((idxNum >> argpos) & 1) {
+            sqlite3_value *value = nullptr;
+            int rc = sqlite3_vtab_in_first(arg, &value);
+            while (rc == SQLITE_OK) {
+                int rc2 = f(value);
+                if (rc2 != SQLITE_OK) {
+                    return rc2;
+                }
+                rc = sqlite3_vtab_in_next(arg, &value);
+            }
+            return rc == SQLITE_DONE ? SQLITE_OK : rc;
+        }
+#endif
+        return f(arg);
+    }
+
     // record error message to be passed to caller
     void Error(const std::string &msg);
 };
@@ -151,13 +174,20 @@ class SQLiteVirtualTable {
     // If the function is passed fewer than max_args arguments, they're treated as a prefix of the
     // hidden columns.
     //
-    int BestIndexTVF(sqlite3_index_info *info, int visible_cols, int min_args, int max_args) {
+    // batch_in_args is a bitmap of argument positions willing to receive an IN-operator value
+    // list all at once via SQLite's sqlite3_vtab_in() protocol (instead of SQLite re-invoking
+    // Filter() once per value). For each position actually batched, the corresponding bit is set
+    // in info->idxNum, and the cursor's Filter() must consume the list via ForEachFilterValue().
+    //
+    int BestIndexTVF(sqlite3_index_info *info, int visible_cols, int min_args, int max_args,
+                     long long batch_in_args = 0) {
         assert(visible_cols >= 0 && min_args >= 0 && min_args <= max_args &&
                visible_cols + max_args <= 62);
         if (info->nConstraint < min_args || info->nConstraint > max_args) {
             return SQLITE_CONSTRAINT;
         }
         long long arg_bitmap = 0;
+        info->idxNum = 0;
         for (int i = 0; i < info->nConstraint; ++i) {
             auto &constraint = info->aConstraint[i];
             int arg = constraint.iColumn - visible_cols;
@@ -170,6 +200,12 @@ class SQLiteVirtualTable {
             // have argument passed in the proper order to SQLiteVirtualTableCursor::Filter()
             info->aConstraintUsage[i].argvIndex = arg + 1;
             info->aConstraintUsage[i].omit = true;
+#if SQLITE_VERSION_NUMBER >= 3038000
+            if ((batch_in_args >> arg) & 1 && sqlite3_libversion_number() >= 3038000 &&
+                sqlite3_vtab_in(info, i, 1)) {
+                info->idxNum |= 1 << arg;
+            }
+#endif
         }
         // constrained columns should form a prefix of the hidden columns
         if (arg_bitmap != (1 << info->nConstraint) - 1) {
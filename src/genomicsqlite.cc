@@ -1,7 +1,13 @@
 #include <assert.h>
+#include <atomic>
+#include <condition_variable>
+#include <errno.h>
+#include <functional>
+#include <mutex>
 #include <sqlite3ext.h>
 #include <sstream>
 #include <thread>
+#include <tuple>
 #include <vector>
 extern "C" {
 SQLITE_EXTENSION_INIT1
@@ -62,7 +68,9 @@ std::string GenomicSQLiteDefaultConfigJSON() {
     return R"({
     "unsafe_load": false,
     "immutable": false,
+    "frozen": false,
     "page_cache_MiB": 1024,
+    "shared_cache": false,
     "threads": -1,
     "force_prefetch": false,
     "zstd_level": 6,
@@ -161,6 +169,56 @@ class ConfigParser {
     bool GetBool(const char *path) { return GetInt(path) != 0; }
 };
 
+// The configuration options used by GenomicSQLiteURI() and GenomicSQLiteTuningSQL(), parsed out
+// of the merged config JSON into a plain struct.
+struct ParsedConfig {
+    bool unsafe_load, immutable, frozen, force_prefetch, shared_cache, web_insecure, web_nodbi;
+    int page_cache_MiB, threads, zstd_level, inner_page_KiB, outer_page_KiB, vfs_log,
+        web_small_KiB;
+    string mode, web_dbi_url;
+};
+
+// Parse config JSON, memoized process-wide on the verbatim config_json string: each ConfigParser
+// opens a :memory: connection and prepares statements just to read a dozen options, which is
+// needless overhead on repeat opens with the same JSON (the overwhelmingly common case).
+static ParsedConfig ParseConfig(const string &config_json) {
+    static map<string, ParsedConfig> memo;
+    static mutex memo_mutex;
+    {
+        lock_guard<mutex> lock(memo_mutex);
+        auto hit = memo.find(config_json);
+        if (hit != memo.end()) {
+            return hit->second;
+        }
+    }
+
+    ConfigParser cfg(config_json);
+    ParsedConfig ans;
+    ans.unsafe_load = cfg.GetBool("$.unsafe_load");
+    ans.immutable = cfg.GetBool("$.immutable");
+    ans.frozen = cfg.GetBool("$.frozen");
+    ans.force_prefetch = cfg.GetBool("$.force_prefetch");
+    ans.shared_cache = cfg.GetBool("$.shared_cache");
+    ans.web_insecure = cfg.GetBool("$.web_insecure");
+    ans.web_nodbi = cfg.GetBool("$.web_nodbi");
+    ans.page_cache_MiB = cfg.GetInt("$.page_cache_MiB");
+    ans.threads = cfg.GetInt("$.threads");
+    ans.zstd_level = cfg.GetInt("$.zstd_level");
+    ans.inner_page_KiB = cfg.GetInt("$.inner_page_KiB");
+    ans.outer_page_KiB = cfg.GetInt("$.outer_page_KiB");
+    ans.vfs_log = cfg.GetInt("$.vfs_log");
+    ans.web_small_KiB = cfg.GetInt("$.web_small_KiB");
+    ans.mode = cfg.GetString("$.mode", "");
+    ans.web_dbi_url = cfg.GetString("$.web_dbi_url");
+
+    lock_guard<mutex> lock(memo_mutex);
+    if (memo.size() >= 256) { // bound memory if config JSONs are being generated dynamically
+        memo.clear();
+    }
+    memo[config_json] = ans;
+    return ans;
+}
+
 extern "C" char *genomicsqlite_default_config_json() { C_WRAPPER(GenomicSQLiteDefaultConfigJSON()) }
 
 static void sqlfn_genomicsqlite_default_config_json(sqlite3_context *ctx, int argc,
@@ -168,47 +226,78 @@ static void sqlfn_genomicsqlite_default_config_json(sqlite3_context *ctx, int ar
     SQL_WRAPPER(GenomicSQLiteDefaultConfigJSON())}
 
 string GenomicSQLiteURI(const string &dbfile, const string &config_json = "") {
-    ConfigParser cfg(config_json);
+    ParsedConfig cfg = ParseConfig(config_json);
 
     bool web = dbfile.substr(0, 5) == "http:" || dbfile.substr(0, 6) == "https:";
+    if (cfg.frozen) {
+        // "frozen" database: a plain, uncompressed SQLite file served without the compression
+        // layer, so that read-only page access can go through mmap with zero decompression or
+        // copying (see GenomicSQLiteTuningSQL). Produced by GenomicSQLiteVacuumIntoSQL with the
+        // same config option.
+        if (web) {
+            throw std::invalid_argument(
+                "GenomicSQLite: frozen mode applies to local files, not web URLs");
+        }
+        ostringstream plain;
+        plain << "file:" << SQLiteNested::urlencode(dbfile, true);
+        char sep = '?';
+        if (!cfg.mode.empty()) {
+            plain << sep << "mode=" << cfg.mode;
+            sep = '&';
+        }
+        if (cfg.immutable) {
+            plain << sep << "immutable=1";
+            sep = '&';
+        }
+        if (cfg.shared_cache) {
+            plain << sep << "cache=shared";
+        }
+        _DBG << plain.str() << endl;
+        return plain.str();
+    }
     ostringstream uri;
     uri << "file:" << (web ? "/__web__" : SQLiteNested::urlencode(dbfile, true)) << "?vfs=zstd";
-    if (cfg.GetInt("$.vfs_log") >= 0) {
-        uri << "&vfs_log=" << cfg.GetInt("$.vfs_log");
+    if (cfg.vfs_log >= 0) {
+        uri << "&vfs_log=" << cfg.vfs_log;
     }
     if (web) {
         uri << "&mode=ro&immutable=1&web_url=" << SQLiteNested::urlencode(dbfile);
-        if (cfg.GetBool("$.web_insecure")) {
+        if (cfg.web_insecure) {
             uri << "&web_insecure=1";
         }
-        if (cfg.GetBool("$.web_nodbi")) {
+        if (cfg.web_nodbi) {
             uri << "&web_nodbi=1";
-        } else {
-            auto web_dbi_url = cfg.GetString("$.web_dbi_url");
-            if (!web_dbi_url.empty()) {
-                uri << "&web_dbi_url=" << SQLiteNested::urlencode(web_dbi_url);
-            }
+        } else if (!cfg.web_dbi_url.empty()) {
+            uri << "&web_dbi_url=" << SQLiteNested::urlencode(cfg.web_dbi_url);
         }
-        uri << "&web_small_KiB=" << cfg.GetInt("$.web_small_KiB");
+        uri << "&web_small_KiB=" << cfg.web_small_KiB;
+    }
+    if (cfg.shared_cache) {
+        // connections to the same file within the process share one cache of decompressed
+        // (inner) pages, instead of hot pages being decompressed & cached once per connection.
+        // For read-mostly serving; with immutable=1 there's no invalidation traffic at all.
+        uri << "&cache=shared";
     }
-    int threads = cfg.GetInt("$.threads");
-    uri << "&outer_cache_size=" << to_string(-64 * cfg.GetInt("$.page_cache_MiB"))
-        << "&threads=" << to_string(threads);
-    if (threads > 1 && cfg.GetInt("$.inner_page_KiB") < 16 && !cfg.GetBool("$.force_prefetch")) {
-        // prefetch is usually counterproductive if inner_page_KiB < 16
+    uri << "&outer_cache_size=" << to_string(-64 * cfg.page_cache_MiB)
+        << "&threads=" << to_string(cfg.threads);
+    if (!web && cfg.threads > 1 && cfg.inner_page_KiB < 16 && !cfg.force_prefetch) {
+        // prefetch is usually counterproductive if inner_page_KiB < 16 -- except over http(s),
+        // where the prefetch pool's background reads become several concurrent ranged GETs kept
+        // in flight ahead of the decompression stage, the difference between a sequential scan
+        // crawling at one request per round trip and saturating the link. (Also, the local
+        // inner_page_KiB setting doesn't necessarily describe a remote database.)
         uri << "&noprefetch=1";
     }
     if (!web) {
-        string mode = cfg.GetString("$.mode", "");
-        if (!mode.empty()) {
-            uri << "&mode=" << mode;
+        if (!cfg.mode.empty()) {
+            uri << "&mode=" << cfg.mode;
         }
-        uri << "&outer_page_size=" << to_string(cfg.GetInt("$.outer_page_KiB") * 1024);
-        uri << "&level=" << to_string(cfg.GetInt("$.zstd_level"));
-        if (cfg.GetBool("$.immutable")) {
+        uri << "&outer_page_size=" << to_string(cfg.outer_page_KiB * 1024);
+        uri << "&level=" << to_string(cfg.zstd_level);
+        if (cfg.immutable) {
             uri << "&immutable=1";
         }
-        if (cfg.GetBool("$.unsafe_load")) {
+        if (cfg.unsafe_load) {
             uri << "&nolock=1&outer_unsafe=1";
         }
     }
@@ -273,22 +362,42 @@ static void sqlfn_genomicsqlite_uri(sqlite3_context *ctx, int argc, sqlite3_valu
 }
 
 string GenomicSQLiteTuningSQL(const string &config_json, const string &schema = "") {
-    ConfigParser cfg(config_json);
+    ParsedConfig cfg = ParseConfig(config_json);
 
     string schema_prefix;
     if (!schema.empty()) {
         schema_prefix = schema + ".";
     }
     map<string, string> pragmas;
-    pragmas[schema_prefix + "cache_size"] = to_string(-960 * cfg.GetInt("$.page_cache_MiB"));
+    pragmas[schema_prefix + "cache_size"] = to_string(-960 * cfg.page_cache_MiB);
+    if (cfg.frozen) {
+        // frozen database: no compression layer, so serve read-only page access straight from the
+        // OS page cache via mmap, zero-copy and with no decompression. SQLite silently caps the
+        // size at its compile-time maximum. The remaining pragmas concern the compression layer
+        // or bulk-loading, so they don't apply.
+        pragmas[schema_prefix + "mmap_size"] = "1099511627776";
+        if (schema_prefix.empty()) {
+            pragmas["threads"] = to_string(cfg.threads >= 0
+                                               ? cfg.threads
+                                               : std::min(8, (int)thread::hardware_concurrency()));
+        }
+        ostringstream frozen_out;
+        bool first = true;
+        for (const auto &p : pragmas) {
+            frozen_out << (first ? "PRAGMA " : "; PRAGMA ") << p.first << "=" << p.second;
+            first = false;
+        }
+        _DBG << frozen_out.str() << endl;
+        return frozen_out.str();
+    }
     pragmas[schema_prefix + "max_page_count"] = "2147483646";
     pragmas[schema_prefix + "secure_delete"] = "ON"; // ensures empty space compresses to ~nothing
     if (schema_prefix.empty()) {
-        int threads = cfg.GetInt("$.threads");
-        pragmas["threads"] =
-            to_string(threads >= 0 ? threads : std::min(8, (int)thread::hardware_concurrency()));
+        pragmas["threads"] = to_string(cfg.threads >= 0
+                                           ? cfg.threads
+                                           : std::min(8, (int)thread::hardware_concurrency()));
     }
-    if (cfg.GetBool("$.unsafe_load")) {
+    if (cfg.unsafe_load) {
         pragmas[schema_prefix + "journal_mode"] = "OFF";
         pragmas[schema_prefix + "synchronous"] = "OFF";
         pragmas[schema_prefix + "locking_mode"] = "EXCLUSIVE";
@@ -300,7 +409,7 @@ string GenomicSQLiteTuningSQL(const string &config_json, const string &schema =
     ostringstream out;
     // must go first:
     out << "PRAGMA " << schema_prefix
-        << "page_size=" << to_string(cfg.GetInt("$.inner_page_KiB") * 1024);
+        << "page_size=" << to_string(cfg.inner_page_KiB * 1024);
     for (const auto &p : pragmas) {
         out << "; PRAGMA " << p.first << "=" << p.second;
     }
@@ -424,6 +533,257 @@ unique_ptr<SQLite::Database> GenomicSQLiteOpen(const string &dbfile, int flags,
     return db;
 }
 
+struct GenomicSQLitePool::Impl {
+    string dbfile, config_json;
+    int flags;
+    size_t max_connections, outstanding = 0;
+    vector<sqlite3 *> idle;
+    mutex mu;
+    condition_variable cv;
+};
+
+GenomicSQLitePool::GenomicSQLitePool(const string &dbfile, int flags, const string &config_json,
+                                     size_t max_connections)
+    : impl_(new Impl) {
+    if (max_connections < 1) {
+        throw std::invalid_argument("GenomicSQLitePool: max_connections must be >= 1");
+    }
+    impl_->dbfile = dbfile;
+    impl_->config_json = config_json;
+    impl_->flags = flags;
+    impl_->max_connections = max_connections;
+}
+
+GenomicSQLitePool::~GenomicSQLitePool() {
+    assert(impl_->outstanding == 0);
+    for (sqlite3 *db : impl_->idle) {
+        sqlite3_close_v2(db);
+    }
+}
+
+sqlite3 *GenomicSQLitePool::Checkout() {
+    unique_lock<mutex> lock(impl_->mu);
+    while (impl_->idle.empty() && impl_->outstanding >= impl_->max_connections) {
+        impl_->cv.wait(lock);
+    }
+    ++impl_->outstanding;
+    if (!impl_->idle.empty()) {
+        sqlite3 *db = impl_->idle.back();
+        impl_->idle.pop_back();
+        return db;
+    }
+    // open a new connection outside the lock, so a slow open doesn't serialize other checkouts
+    lock.unlock();
+    sqlite3 *db = nullptr;
+    string errmsg;
+    int rc = GenomicSQLiteOpen(impl_->dbfile, &db, errmsg, impl_->flags, impl_->config_json);
+    if (rc != SQLITE_OK) {
+        sqlite3_close_v2(db);
+        lock.lock();
+        --impl_->outstanding;
+        impl_->cv.notify_one();
+        throw SQLite::Exception(errmsg, rc);
+    }
+    return db;
+}
+
+void GenomicSQLitePool::Checkin(sqlite3 *db) {
+    if (!db) {
+        return;
+    }
+    // roll back any transaction the checkout left open, so the next one starts clean; harmless
+    // error if there's none. The connection's warmed page & VFS caches carry over.
+    sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+    lock_guard<mutex> lock(impl_->mu);
+    assert(impl_->outstanding > 0);
+    --impl_->outstanding;
+    impl_->idle.push_back(db);
+    impl_->cv.notify_one();
+}
+
+extern "C" int genomicsqlite_pool_create(const char *dbfile, int flags, const char *config_json,
+                                         int max_connections, genomicsqlite_pool **ppPool,
+                                         char **pzErrMsg) {
+    try {
+        *ppPool = reinterpret_cast<genomicsqlite_pool *>(
+            new GenomicSQLitePool(string(dbfile), flags, config_json ? config_json : "",
+                                  max_connections > 0 ? max_connections : 16));
+        return SQLITE_OK;
+    } catch (std::bad_alloc &) {
+        return SQLITE_NOMEM;
+    } catch (std::exception &exn) {
+        if (pzErrMsg) {
+            *pzErrMsg = sqlite3_mprintf("%s", exn.what());
+        }
+        return SQLITE_ERROR;
+    }
+}
+
+extern "C" int genomicsqlite_pool_checkout(genomicsqlite_pool *pool, sqlite3 **ppDb,
+                                           char **pzErrMsg) {
+    try {
+        *ppDb = reinterpret_cast<GenomicSQLitePool *>(pool)->Checkout();
+        return SQLITE_OK;
+    } catch (SQLite::Exception &exn) {
+        if (pzErrMsg) {
+            *pzErrMsg = sqlite3_mprintf("%s", exn.what());
+        }
+        return exn.getErrorCode();
+    } catch (std::exception &exn) {
+        if (pzErrMsg) {
+            *pzErrMsg = sqlite3_mprintf("%s", exn.what());
+        }
+        return SQLITE_ERROR;
+    }
+}
+
+extern "C" void genomicsqlite_pool_checkin(genomicsqlite_pool *pool, sqlite3 *db) {
+    reinterpret_cast<GenomicSQLitePool *>(pool)->Checkin(db);
+}
+
+extern "C" void genomicsqlite_pool_destroy(genomicsqlite_pool *pool) {
+    delete reinterpret_cast<GenomicSQLitePool *>(pool);
+}
+
+// Scatter/gather over a pool of reader connections: SQLite runs each query on one thread, so
+// whole-genome aggregations otherwise use one core no matter the $.threads setting (which covers
+// only compression & sorting). Partition the work by reference sequence -- one task per _gri_rid
+// found in _gri_refseq, bound to the caller's ?1 -- and fan the tasks out across the pool,
+// funneling result rows through the serialized callback.
+sqlite3_int64 GenomicSQLiteParallelScan(const string &dbfile, const string &config_json,
+                                        const string &sql,
+                                        const function<int(sqlite3_stmt *)> &row_callback,
+                                        size_t max_connections) {
+    GenomicSQLitePool pool(dbfile, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, config_json,
+                           max_connections);
+
+    // enumerate the partitions
+    vector<sqlite3_int64> rids;
+    {
+        sqlite3 *conn = pool.Checkout();
+        sqlite3_stmt *pStmt = nullptr;
+        int rc = sqlite3_prepare_v2(conn, "SELECT DISTINCT _gri_rid FROM _gri_refseq ORDER BY 1",
+                                    -1, &pStmt, nullptr);
+        if (rc != SQLITE_OK) {
+            string msg = "genomicsqlite_parallel_scan(): database lacks _gri_refseq; " +
+                         string(sqlite3_errmsg(conn));
+            pool.Checkin(conn);
+            throw runtime_error(msg);
+        }
+        while ((rc = sqlite3_step(pStmt)) == SQLITE_ROW) {
+            if (sqlite3_column_type(pStmt, 0) == SQLITE_INTEGER) {
+                rids.push_back(sqlite3_column_int64(pStmt, 0));
+            }
+        }
+        sqlite3_finalize(pStmt);
+        pool.Checkin(conn);
+        if (rc != SQLITE_DONE) {
+            throw runtime_error("genomicsqlite_parallel_scan(): error reading _gri_refseq");
+        }
+    }
+    if (rids.empty()) {
+        return 0;
+    }
+
+    atomic<size_t> next_task(0);
+    atomic<bool> stop(false);
+    mutex gather_mutex; // serializes row_callback and first-error capture
+    sqlite3_int64 rows = 0;
+    string errmsg;
+
+    auto worker = [&]() {
+        sqlite3 *conn = nullptr;
+        unique_ptr<sqlite3_stmt, int (*)(sqlite3_stmt *)> stmt(nullptr, sqlite3_finalize);
+        try {
+            conn = pool.Checkout();
+            sqlite3_stmt *pStmt = nullptr;
+            if (sqlite3_prepare_v2(conn, sql.c_str(), -1, &pStmt, nullptr) != SQLITE_OK) {
+                throw runtime_error("genomicsqlite_parallel_scan(): " +
+                                    string(sqlite3_errmsg(conn)));
+            }
+            stmt.reset(pStmt);
+            size_t task;
+            while (!stop.load(std::memory_order_relaxed) &&
+                   (task = next_task.fetch_add(1)) < rids.size()) {
+                if (sqlite3_bind_int64(stmt.get(), 1, rids[task]) != SQLITE_OK) {
+                    throw runtime_error(
+                        "genomicsqlite_parallel_scan(): sql must reference the partition's"
+                        " _gri_rid as ?1");
+                }
+                int rc;
+                while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
+                    lock_guard<mutex> lock(gather_mutex);
+                    if (stop) {
+                        break;
+                    }
+                    ++rows;
+                    if (row_callback(stmt.get())) {
+                        stop = true; // caller aborted; not an error
+                        break;
+                    }
+                }
+                if (rc != SQLITE_DONE && rc != SQLITE_ROW) {
+                    throw runtime_error("genomicsqlite_parallel_scan(): " +
+                                        string(sqlite3_errmsg(conn)));
+                }
+                sqlite3_reset(stmt.get());
+            }
+        } catch (std::exception &exn) {
+            lock_guard<mutex> lock(gather_mutex);
+            if (errmsg.empty()) {
+                errmsg = exn.what();
+            }
+            stop = true;
+        }
+        stmt.reset();
+        if (conn) {
+            pool.Checkin(conn);
+        }
+    };
+
+    vector<thread> workers;
+    size_t nworkers = std::min(max_connections, rids.size());
+    for (size_t i = 0; i < std::max(nworkers, size_t(1)); ++i) {
+        workers.emplace_back(worker);
+    }
+    for (auto &t : workers) {
+        t.join();
+    }
+    if (!errmsg.empty()) {
+        throw runtime_error(errmsg);
+    }
+    return rows;
+}
+
+extern "C" int genomicsqlite_parallel_scan(const char *dbfile, const char *config_json,
+                                           const char *sql, int max_connections,
+                                           int (*row_callback)(void *, sqlite3_stmt *), void *ctx,
+                                           sqlite3_int64 *pnRows, char **pzErrMsg) {
+    assert(dbfile && dbfile[0]);
+    assert(sql && sql[0]);
+    assert(row_callback);
+    try {
+        sqlite3_int64 n = GenomicSQLiteParallelScan(
+            string(dbfile), config_json ? config_json : "", sql,
+            [row_callback, ctx](sqlite3_stmt *row) { return row_callback(ctx, row); },
+            max_connections > 0 ? max_connections : 16);
+        if (pnRows) {
+            *pnRows = n;
+        }
+        return SQLITE_OK;
+    } catch (SQLite::Exception &exn) {
+        if (pzErrMsg) {
+            *pzErrMsg = sqlite3_mprintf("%s", exn.what());
+        }
+        return exn.getErrorCode();
+    } catch (std::exception &exn) {
+        if (pzErrMsg) {
+            *pzErrMsg = sqlite3_mprintf("%s", exn.what());
+        }
+        return SQLITE_ERROR;
+    }
+}
+
 static string sqlquote(const std::string &v) {
     ostringstream ans;
     ans << "'";
@@ -462,11 +822,15 @@ static void sqlfn_genomicsqlite_attach_sql(sqlite3_context *ctx, int argc, sqlit
 }
 
 string GenomicSQLiteVacuumIntoSQL(const string &destfile, const string &config_json) {
-    string desturi = GenomicSQLiteURI(destfile, config_json) + "&outer_unsafe=1";
+    ParsedConfig cfg = ParseConfig(config_json);
+    string desturi = GenomicSQLiteURI(destfile, config_json);
+    if (!cfg.frozen) {
+        // (a frozen destination is a plain SQLite file with no outer database to unsafe-load)
+        desturi += "&outer_unsafe=1";
+    }
 
-    ConfigParser cfg(config_json);
     ostringstream ans;
-    ans << "PRAGMA page_size = " << (cfg.GetInt("$.inner_page_KiB") * 1024) << ";\nVACUUM INTO "
+    ans << "PRAGMA page_size = " << (cfg.inner_page_KiB * 1024) << ";\nVACUUM INTO "
         << sqlquote(desturi);
     return ans.str();
 }
@@ -483,6 +847,47 @@ static void sqlfn_genomicsqlite_vacuum_into_sql(sqlite3_context *ctx, int argc,
     SQL_WRAPPER(GenomicSQLiteVacuumIntoSQL(destfile, config_json))
 }
 
+void GenomicSQLiteVacuumInto(const string &srcfile, const string &destfile,
+                             const string &config_json) {
+    // Open the source on a dedicated read-only connection and run the VACUUM INTO script on it,
+    // sparing the caller from managing a connection just for the copy.
+    sqlite3 *rawdb = nullptr;
+    string errmsg;
+    int rc = GenomicSQLiteOpen(srcfile, &rawdb, errmsg,
+                               SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, config_json);
+    unique_ptr<sqlite3, int (*)(sqlite3 *)> db(rawdb, sqlite3_close_v2);
+    if (rc != SQLITE_OK) {
+        throw SQLite::Exception(errmsg.empty() ? string(sqlite3_errstr(rc)) : errmsg, rc);
+    }
+    char *zErrmsg = nullptr;
+    rc = sqlite3_exec(db.get(), GenomicSQLiteVacuumIntoSQL(destfile, config_json).c_str(), nullptr,
+                      nullptr, &zErrmsg);
+    if (rc != SQLITE_OK) {
+        string msg = zErrmsg ? zErrmsg : sqlite3_errmsg(db.get());
+        sqlite3_free(zErrmsg);
+        throw SQLite::Exception(msg, rc);
+    }
+}
+
+extern "C" int genomicsqlite_vacuum_into(const char *srcfile, const char *destfile,
+                                         char **pzErrMsg, const char *config_json) {
+    try {
+        GenomicSQLiteVacuumInto(string(srcfile), string(destfile),
+                                config_json ? config_json : "");
+        return SQLITE_OK;
+    } catch (SQLite::Exception &exn) {
+        if (pzErrMsg) {
+            *pzErrMsg = sqlite3_mprintf("%s", exn.what());
+        }
+        return exn.getErrorCode();
+    } catch (std::exception &exn) {
+        if (pzErrMsg) {
+            *pzErrMsg = sqlite3_mprintf("%s", exn.what());
+        }
+        return SQLITE_ERROR;
+    }
+}
+
 /**************************************************************************************************
  * GRI implementation
  **************************************************************************************************/
@@ -548,7 +953,92 @@ static void sqlfn_create_genomic_range_index_sql(sqlite3_context *ctx, int argc,
     SQL_WRAPPER(CreateGenomicRangeIndexSQL(schema_table, rid, beg, end, floor))
 }
 
-static pair<int, int> DetectLevelRange(sqlite3 *dbconn, const string &schema_table) {
+void CreateGenomicRangeIndex(sqlite3 *dbconn, const string &schema_table, const string &rid,
+                             const string &beg, const string &end, int floor) {
+    string ddl = CreateGenomicRangeIndexSQL(schema_table, rid, beg, end, floor);
+    // The virtual-column key tuples make the sort the bulk of the CREATE INDEX work, and SQLite's
+    // sorter can compute & external-sort runs on background threads (the final b-tree append is
+    // inherently serial). PRAGMA threads defaults to zero, so temporarily raise it to the core
+    // count; SQLite itself clamps that to its compiled-in maximum (usually 8).
+    int threads0 = 0;
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(dbconn, "PRAGMA threads", -1, &stmt, nullptr) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW) {
+        threads0 = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    int nproc = (int)thread::hardware_concurrency();
+    if (nproc > threads0) {
+        string pragma = "PRAGMA threads=" + to_string(nproc);
+        sqlite3_exec(dbconn, pragma.c_str(), nullptr, nullptr, nullptr);
+    }
+    char *zErrmsg = nullptr;
+    int rc = sqlite3_exec(dbconn, ddl.c_str(), nullptr, nullptr, &zErrmsg);
+    string msg;
+    if (rc != SQLITE_OK) {
+        msg = zErrmsg ? zErrmsg : sqlite3_errmsg(dbconn);
+    }
+    sqlite3_free(zErrmsg);
+    if (nproc > threads0) {
+        string pragma = "PRAGMA threads=" + to_string(threads0);
+        sqlite3_exec(dbconn, pragma.c_str(), nullptr, nullptr, nullptr);
+    }
+    if (rc != SQLITE_OK) {
+        throw SQLite::Exception(msg, rc);
+    }
+}
+
+extern "C" int create_genomic_range_index(sqlite3 *dbconn, const char *table, const char *rid,
+                                          const char *beg, const char *end, int floor,
+                                          char **pzErrMsg) {
+    assert(dbconn);
+    assert(table && table[0]);
+    assert(rid && rid[0]);
+    assert(beg && beg[0]);
+    assert(end && end[0]);
+    try {
+        CreateGenomicRangeIndex(dbconn, string(table), rid, beg, end, floor);
+        return SQLITE_OK;
+    } catch (SQLite::Exception &exn) {
+        if (pzErrMsg) {
+            *pzErrMsg = sqlite3_mprintf("%s", exn.what());
+        }
+        return exn.getErrorCode();
+    } catch (std::exception &exn) {
+        if (pzErrMsg) {
+            *pzErrMsg = sqlite3_mprintf("%s", exn.what());
+        }
+        return SQLITE_ERROR;
+    }
+}
+
+// Consult the optional _gri_levels metadata table (written by
+// PutGenomicRangeIndexLevelsSQL(), below) for persisted level bounds of the table's GRI.
+// Returns (min_lvl, max_lvl) or (-1, -1) if absent.
+static pair<int, int> LookupLevelRange(sqlite3 *dbconn, const string &schema_table) {
+    auto split = split_schema_table(schema_table);
+    string query =
+        "SELECT gri_ceiling, gri_floor FROM " + split.first + "_gri_levels WHERE table_name = ?1";
+    sqlite3_stmt *pStmt = nullptr;
+    if (sqlite3_prepare_v3(dbconn, query.c_str(), -1, 0, &pStmt, nullptr) != SQLITE_OK) {
+        return std::pair<int, int>(-1, -1); // _gri_levels doesn't exist
+    }
+    shared_ptr<sqlite3_stmt> stmt(pStmt, sqlite3_finalize);
+    if (sqlite3_bind_text(stmt.get(), 1, split.second.c_str(), -1, SQLITE_TRANSIENT) != SQLITE_OK ||
+        sqlite3_step(stmt.get()) != SQLITE_ROW ||
+        sqlite3_column_type(stmt.get(), 0) != SQLITE_INTEGER ||
+        sqlite3_column_type(stmt.get(), 1) != SQLITE_INTEGER) {
+        return std::pair<int, int>(-1, -1);
+    }
+    sqlite3_int64 max_lvl = sqlite3_column_int64(stmt.get(), 0),
+                  min_lvl = sqlite3_column_int64(stmt.get(), 1);
+    if (!(0 <= min_lvl && min_lvl <= max_lvl && max_lvl < 16)) {
+        throw runtime_error("GenomicSQLite: _gri_levels corrupted");
+    }
+    return std::pair<int, int>(min_lvl, max_lvl);
+}
+
+static pair<int, int> ScanLevelRange(sqlite3 *dbconn, const string &schema_table) {
     string table = split_schema_table(schema_table).second;
 
     // Detect min & max level actually occupied in the table's GRI.
@@ -618,6 +1108,41 @@ static pair<int, int> DetectLevelRange(sqlite3 *dbconn, const string &schema_tab
     return std::pair<int, int>(min_lvl, max_lvl);
 }
 
+static pair<int, int> DetectLevelRange(sqlite3 *dbconn, const string &schema_table) {
+    // Fast path: level bounds persisted at index-build/load time, if any, spare a fresh
+    // connection the full index scan (which over e.g. the web VFS can cost several HTTP round
+    // trips before the first real query).
+    auto persisted = LookupLevelRange(dbconn, schema_table);
+    if (persisted.first >= 0) {
+        return persisted;
+    }
+    return ScanLevelRange(dbconn, schema_table);
+}
+
+string PutGenomicRangeIndexLevelsSQL(sqlite3 *dbconn, const string &schema_table) {
+    auto split = split_schema_table(schema_table);
+    auto lvls = ScanLevelRange(dbconn, schema_table);
+    ostringstream out;
+    out << "CREATE TABLE IF NOT EXISTS " << split.first
+        << "_gri_levels(table_name TEXT NOT NULL PRIMARY KEY, gri_ceiling INTEGER NOT NULL, gri_floor INTEGER NOT NULL)"
+        << ";\nINSERT OR REPLACE INTO " << split.first << "_gri_levels(table_name,gri_ceiling,gri_floor) VALUES("
+        << sqlquote(split.second) << "," << lvls.second << "," << lvls.first << ")";
+    return out.str();
+}
+
+extern "C" char *put_genomic_range_index_levels_sql(sqlite3 *dbconn, const char *table) {
+    assert(table && table[0]);
+    C_WRAPPER(PutGenomicRangeIndexLevelsSQL(dbconn, string(table)));
+}
+
+static void sqlfn_put_genomic_range_index_levels_sql(sqlite3_context *ctx, int argc,
+                                                     sqlite3_value **argv) {
+    string schema_table;
+    assert(argc == 1);
+    ARG_TEXT(schema_table, 0)
+    SQL_WRAPPER(PutGenomicRangeIndexLevelsSQL(sqlite3_context_db_handle(ctx), schema_table))
+}
+
 string GenomicRangeRowidsSQL(sqlite3 *dbconn, const string &indexed_table, const string &qrid,
                              const string &qbeg, const string &qend, int ceiling, int floor) {
     if (ceiling < 0) {
@@ -681,6 +1206,87 @@ static void sqlfn_genomic_range_rowids_sql(sqlite3_context *ctx, int argc, sqlit
                                       qend, (int)ceiling, (int)floor))
 }
 
+// Warm caches for a genomic range ahead of latency-critical queries: run the GRI probe and seek
+// the table b-tree to each resulting rowid, pulling the referenced index & table pages through
+// the VFS (fetch + decompression) into the page cache without materializing any rows. COUNT(*)
+// over `_rowid_ IN (GRI query)` does exactly that seek-per-rowid, returning only the tally.
+sqlite3_int64 GenomicSQLitePrefetch(sqlite3 *dbconn, const string &table, const string &qrid,
+                                    sqlite3_int64 qbeg, sqlite3_int64 qend) {
+    string sql = "SELECT COUNT(*) FROM " + table + " WHERE " + table + "._rowid_ IN " +
+                 GenomicRangeRowidsSQL(dbconn, table);
+    sqlite3_stmt *pStmt = nullptr;
+    if (sqlite3_prepare_v3(dbconn, sql.c_str(), -1, 0, &pStmt, nullptr) != SQLITE_OK) {
+        throw runtime_error("genomicsqlite_prefetch(): table doesn't exist or lacks GRI; " +
+                            string(sqlite3_errmsg(dbconn)));
+    }
+    shared_ptr<sqlite3_stmt> stmt(pStmt, sqlite3_finalize);
+    if (sqlite3_bind_text(stmt.get(), 1, qrid.c_str(), -1, SQLITE_TRANSIENT) != SQLITE_OK ||
+        sqlite3_bind_int64(stmt.get(), 2, qbeg) != SQLITE_OK ||
+        sqlite3_bind_int64(stmt.get(), 3, qend) != SQLITE_OK) {
+        throw runtime_error("GenomicSQLite: error binding GRI query parameters");
+    }
+    if (sqlite3_step(stmt.get()) != SQLITE_ROW) {
+        throw runtime_error("genomicsqlite_prefetch(): " + string(sqlite3_errmsg(dbconn)));
+    }
+    return sqlite3_column_int64(stmt.get(), 0);
+}
+
+extern "C" int genomicsqlite_prefetch(sqlite3 *dbconn, const char *table, const char *qrid,
+                                      sqlite3_int64 qbeg, sqlite3_int64 qend,
+                                      sqlite3_int64 *pnRows, char **pzErrMsg) {
+    assert(dbconn);
+    assert(table && table[0]);
+    assert(qrid && qrid[0]);
+    try {
+        sqlite3_int64 n = GenomicSQLitePrefetch(dbconn, string(table), qrid, qbeg, qend);
+        if (pnRows) {
+            *pnRows = n;
+        }
+        return SQLITE_OK;
+    } catch (SQLite::Exception &exn) {
+        if (pzErrMsg) {
+            *pzErrMsg = sqlite3_mprintf("%s", exn.what());
+        }
+        return exn.getErrorCode();
+    } catch (std::exception &exn) {
+        if (pzErrMsg) {
+            *pzErrMsg = sqlite3_mprintf("%s", exn.what());
+        }
+        return SQLITE_ERROR;
+    }
+}
+
+// SQL-callable form, taking qrid of any type (TEXT chromosome name or INTEGER rid, per the GRI)
+static void sqlfn_genomic_range_prefetch(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
+    string table;
+    assert(argc == 4);
+    ARG_TEXT(table, 0)
+    try {
+        sqlite3 *dbconn = sqlite3_context_db_handle(ctx);
+        string sql = "SELECT COUNT(*) FROM " + table + " WHERE " + table + "._rowid_ IN " +
+                     GenomicRangeRowidsSQL(dbconn, table);
+        sqlite3_stmt *pStmt = nullptr;
+        if (sqlite3_prepare_v3(dbconn, sql.c_str(), -1, 0, &pStmt, nullptr) != SQLITE_OK) {
+            throw runtime_error("genomic_range_prefetch(): table doesn't exist or lacks GRI; " +
+                                string(sqlite3_errmsg(dbconn)));
+        }
+        shared_ptr<sqlite3_stmt> stmt(pStmt, sqlite3_finalize);
+        if (sqlite3_bind_value(stmt.get(), 1, argv[1]) != SQLITE_OK ||
+            sqlite3_bind_value(stmt.get(), 2, argv[2]) != SQLITE_OK ||
+            sqlite3_bind_value(stmt.get(), 3, argv[3]) != SQLITE_OK) {
+            throw runtime_error("GenomicSQLite: error binding GRI query parameters");
+        }
+        if (sqlite3_step(stmt.get()) != SQLITE_ROW) {
+            throw runtime_error("genomic_range_prefetch(): " + string(sqlite3_errmsg(dbconn)));
+        }
+        sqlite3_result_int64(ctx, sqlite3_column_int64(stmt.get(), 0));
+    } catch (std::bad_alloc &) {
+        sqlite3_result_error_nomem(ctx);
+    } catch (std::exception &exn) {
+        sqlite3_result_error(ctx, exn.what(), -1);
+    }
+}
+
 /**************************************************************************************************
  * genomic_range_rowids() and genomic_range_index_levels() table-valued functions
  **************************************************************************************************/
@@ -692,19 +1298,55 @@ static void sqlfn_genomic_range_rowids_sql(sqlite3_context *ctx, int argc, sqlit
 // less efficient)
 class GenomicRangeRowidsCursor : public SQLiteVirtualTableCursor {
   public:
-    struct table_stmt_cache {
-        int ceiling = 15, floor = 0;
-        vector<shared_ptr<sqlite3_stmt>> pool;
+    // Prepared GRI query statements pooled per (table, ceiling, floor), since the generated SQL
+    // is a function of that tuple. Bounded LRU eviction, so workloads alternating between query
+    // shapes (e.g. broad auto-detected bounds vs. pinned small-feature bounds) each keep their
+    // warm statements instead of re-preparing the multi-level UNION on every alternation.
+    struct stmt_cache {
+        static const size_t MAX_KEYS = 64;
+        struct entry {
+            vector<shared_ptr<sqlite3_stmt>> pool;
+            uint64_t last_use = 0;
+        };
+        map<tuple<string, int, int>, entry> entries;
+        uint64_t clock = 0;
+
+        entry &Get(const string &table, int ceiling, int floor) {
+            auto key = make_tuple(table, ceiling, floor);
+            auto it = entries.find(key);
+            if (it == entries.end()) {
+                if (entries.size() >= MAX_KEYS) {
+                    // evict the least-recently-used key (linear scan; MAX_KEYS is small)
+                    auto lru = entries.begin();
+                    for (auto e = entries.begin(); e != entries.end(); ++e) {
+                        if (e->second.last_use < lru->second.last_use) {
+                            lru = e;
+                        }
+                    }
+                    entries.erase(lru);
+                }
+                it = entries.emplace(key, entry()).first;
+            }
+            it->second.last_use = ++clock;
+            return it->second;
+        }
     };
-    using stmt_cache = map<string, GenomicRangeRowidsCursor::table_stmt_cache>;
 
     GenomicRangeRowidsCursor(sqlite3 *db, stmt_cache &stmt_cache)
-        : db_(db), stmt_cache_(stmt_cache) {}
+        : db_(db), stmt_cache_(stmt_cache) {
+        // For a database opened over http(s), drain each GRI query eagerly (see Filter) so the
+        // index b-tree page fetches go out in one tight burst, instead of being interleaved --
+        // and serialized -- with the outer query's table page fetches as the cursor steps.
+        const char *dbfn = sqlite3_db_filename(db_, "main");
+        web_ = dbfn && sqlite3_uri_parameter(dbfn, "web_url") != nullptr;
+    }
     virtual ~GenomicRangeRowidsCursor() { ReturnStmtToCache(); }
 
     int Filter(int idxNum, const char *idxStr, int argc, sqlite3_value **argv) override {
         ReturnStmtToCache();
         table_name_.clear();
+        drained_.clear();
+        drain_pos_ = 0;
         ceiling_ = 15;
         floor_ = 0;
         if (argc < 4 || argc > 6) {
@@ -734,21 +1376,8 @@ class GenomicRangeRowidsCursor : public SQLiteVirtualTableCursor {
                     throw runtime_error("genomic_range_rowids() ceiling/floor domain error");
                 }
 
-                // find or create the table_stmt_cache for this table
-                auto cache_it = stmt_cache_.find(table_name_);
-                if (cache_it == stmt_cache_.end()) {
-                    stmt_cache_[table_name_] = table_stmt_cache();
-                    cache_it = stmt_cache_.find(table_name_);
-                    assert(cache_it != stmt_cache_.end());
-                }
-                auto &cache = cache_it->second;
-                // if we've been given new level bounds then wipe the cache
-                if (cache.ceiling != ceiling_ || cache.floor != floor_) {
-                    cache.pool.clear();
-                    cache.ceiling = ceiling_;
-                    cache.floor = floor_;
-                }
-
+                // find or create the statement pool for (table, ceiling, floor)
+                auto &cache = stmt_cache_.Get(table_name_, ceiling_, floor_);
                 if (cache.pool.empty()) {
                     // prepare new sqlite3_stmt for GRI query
                     string sql =
@@ -767,11 +1396,41 @@ class GenomicRangeRowidsCursor : public SQLiteVirtualTableCursor {
                     cache.pool.pop_back();
                 }
 
-                if (sqlite3_bind_value(stmt_.get(), 1, argv[1]) != SQLITE_OK ||
-                    sqlite3_bind_value(stmt_.get(), 2, argv[2]) != SQLITE_OK ||
+                if (sqlite3_bind_value(stmt_.get(), 2, argv[2]) != SQLITE_OK ||
                     sqlite3_bind_value(stmt_.get(), 3, argv[3]) != SQLITE_OK) {
                     throw runtime_error("GenomicSQLite: error binding GRI query parameters");
                 }
+                if ((idxNum >> 1) & 1) {
+                    // qrid arrived as a batched IN value list (see BestIndex): run the GRI query
+                    // once per rid through the one prepared statement, buffering all the rowids,
+                    // then sort & dedup so the merged sweep replays in the ascending order our
+                    // orderByConsumed promises.
+                    int rc = ForEachFilterValue(idxNum, 1, argv[1], [this](sqlite3_value *qrid) {
+                        if (sqlite3_bind_value(stmt_.get(), 1, qrid) != SQLITE_OK) {
+                            return SQLITE_ERROR;
+                        }
+                        int rc2;
+                        while ((rc2 = sqlite3_step(stmt_.get())) == SQLITE_ROW) {
+                            drained_.push_back(sqlite3_column_int64(stmt_.get(), 0));
+                        }
+                        sqlite3_reset(stmt_.get());
+                        return rc2 == SQLITE_DONE ? SQLITE_OK : rc2;
+                    });
+                    if (rc != SQLITE_OK) {
+                        stmt_.reset();
+                        return rc;
+                    }
+                    sort(drained_.begin(), drained_.end());
+                    drained_.erase(unique(drained_.begin(), drained_.end()), drained_.end());
+                    ReturnStmtToCache();
+                    return SQLITE_OK;
+                }
+                if (sqlite3_bind_value(stmt_.get(), 1, argv[1]) != SQLITE_OK) {
+                    throw runtime_error("GenomicSQLite: error binding GRI query parameters");
+                }
+                if (web_) {
+                    return DrainStmt();
+                }
                 // later we'll ReturnStmtToCache()
                 return Next(); // step to first result row
             } catch (std::exception &exn) {
@@ -782,6 +1441,10 @@ class GenomicRangeRowidsCursor : public SQLiteVirtualTableCursor {
     }
 
     int Next() override {
+        if (drain_pos_ < drained_.size()) {
+            ++drain_pos_;
+            return SQLITE_OK;
+        }
         if (stmt_) {
             int rc = sqlite3_step(stmt_.get());
             if (rc != SQLITE_ROW) {
@@ -796,9 +1459,17 @@ class GenomicRangeRowidsCursor : public SQLiteVirtualTableCursor {
         return SQLITE_OK;
     }
 
-    int Eof() override { return !stmt_; }
+    int Eof() override { return drain_pos_ >= drained_.size() && !stmt_; }
 
     int Column(sqlite3_context *ctx, int colno) override {
+        if (drain_pos_ < drained_.size()) {
+            if (colno == 0) {
+                sqlite3_result_int64(ctx, drained_[drain_pos_]);
+            } else {
+                sqlite3_result_null(ctx);
+            }
+            return SQLITE_OK;
+        }
         assert(stmt_);
         if (!stmt_)
             return SQLITE_ERROR;
@@ -811,6 +1482,10 @@ class GenomicRangeRowidsCursor : public SQLiteVirtualTableCursor {
     }
 
     int Rowid(sqlite_int64 *pRowid) override {
+        if (drain_pos_ < drained_.size()) {
+            *pRowid = drained_[drain_pos_];
+            return SQLITE_OK;
+        }
         assert(stmt_);
         *pRowid = sqlite3_column_int64(stmt_.get(), 0);
         return SQLITE_OK;
@@ -819,19 +1494,41 @@ class GenomicRangeRowidsCursor : public SQLiteVirtualTableCursor {
   private:
     sqlite3 *db_;
     stmt_cache &stmt_cache_;
+    bool web_ = false;
 
     shared_ptr<sqlite3_stmt> stmt_;
     string table_name_;
     int ceiling_ = 15, floor_ = 0;
 
+    // web read-ahead: rowids drained eagerly at Filter(), replayed by Next()/Column()/Rowid()
+    vector<sqlite3_int64> drained_;
+    size_t drain_pos_ = 0;
+
+    // Run the bound GRI query to completion up front, buffering the rowids (already in ascending
+    // order). Over the web VFS this issues the index probes' page fetches back-to-back, and the
+    // ascending replay gives the outer query a monotonic table b-tree access pattern, both of
+    // which the VFS's extent read-ahead handles far better than latency-bound alternation.
+    int DrainStmt() {
+        drained_.clear();
+        drain_pos_ = 0;
+        int rc;
+        while ((rc = sqlite3_step(stmt_.get())) == SQLITE_ROW) {
+            drained_.push_back(sqlite3_column_int64(stmt_.get(), 0));
+        }
+        if (rc != SQLITE_DONE) {
+            assert(rc != SQLITE_OK);
+            stmt_.reset();
+            return rc;
+        }
+        ReturnStmtToCache();
+        return SQLITE_OK;
+    }
+
     void ReturnStmtToCache() {
         if (stmt_) {
             assert(floor_ >= 0 && ceiling_ >= floor_ && ceiling_ <= 15);
-            auto &cache = stmt_cache_[table_name_];
-            if (cache.ceiling == ceiling_ && cache.floor == floor_) {
-                sqlite3_reset(stmt_.get());
-                cache.pool.push_back(stmt_);
-            }
+            sqlite3_reset(stmt_.get());
+            stmt_cache_.Get(table_name_, ceiling_, floor_).pool.push_back(stmt_);
             stmt_.reset();
         }
     }
@@ -850,7 +1547,7 @@ class GenomicRangeRowidsTVF : public SQLiteVirtualTable {
     GenomicRangeRowidsTVF(sqlite3 *db) : SQLiteVirtualTable(db) {}
 
     int BestIndex(sqlite3_index_info *info) override {
-        int rc = BestIndexTVF(info, 1, 4, 6);
+        int rc = BestIndexTVF(info, 1, 4, 6, 1 << 1); // qrid may come as a batched IN list
         if (rc != SQLITE_OK)
             return rc;
         info->orderByConsumed =
@@ -868,99 +1565,186 @@ class GenomicRangeRowidsTVF : public SQLiteVirtualTable {
     }
 };
 
-// genomic_range_index_levels(tableName): inspect the GRI to detect the gri_ceiling and gri_floor
-// of the (current snapshot of) the given table. (returns just one row)
-class GenomicRangeIndexLevelsCursor : public SQLiteVirtualTableCursor {
+// Companion to genomic_range_rowids() emitting (first_rowid, last_rowid) runs instead of one row
+// per rowid. The GRI query yields rowids in ascending order, and in coordinate-sorted databases
+// they arrive in long consecutive stretches; run-length compressing them lets the caller fetch
+// each run with a single `rowid BETWEEN` range scan instead of a b-tree probe per rowid.
+class GenomicRangeRowidRunsCursor : public SQLiteVirtualTableCursor {
   public:
-    struct cached_levels {
-        uint32_t data_version = UINT32_MAX;
-        int db_total_changes = INT_MAX, ceiling = 15, floor = 0;
-    };
-    using levels_cache = map<string, cached_levels>;
-    GenomicRangeIndexLevelsCursor(sqlite3 *db, levels_cache &cache) : db_(db), cache_(cache) {}
+    GenomicRangeRowidRunsCursor(sqlite3 *db, GenomicRangeRowidsCursor::stmt_cache &stmt_cache)
+        : db_(db), stmt_cache_(stmt_cache) {
+        // eager-drain rationale as in GenomicRangeRowidsCursor
+        const char *dbfn = sqlite3_db_filename(db_, "main");
+        web_ = dbfn && sqlite3_uri_parameter(dbfn, "web_url") != nullptr;
+    }
+    virtual ~GenomicRangeRowidRunsCursor() { ReturnStmtToCache(); }
 
     int Filter(int idxNum, const char *idxStr, int argc, sqlite3_value **argv) override {
-        ceiling_ = floor_ = -1;
-        if (argc != 1) {
-            Error("genomic_range_index_levels() expects 1 argument");
+        ReturnStmtToCache();
+        table_name_.clear();
+        drained_.clear();
+        drain_pos_ = 0;
+        have_run_ = pending_valid_ = replay_ = false;
+        ceiling_ = 15;
+        floor_ = 0;
+        if (argc < 4 || argc > 6) {
+            Error("genomic_range_rowid_runs() expects 4-6 arguments");
         } else if (sqlite3_value_type(argv[0]) != SQLITE_TEXT) {
-            Error("genomic_range_index_levels() expects table name");
+            Error("genomic_range_rowid_runs() argument 1 should be the GRI-indexed table name");
         } else {
-            string table_name = (const char *)sqlite3_value_text(argv[0]);
-            // TODO: sanitize table_name
-            auto schema_table = split_schema_table(table_name);
-            string schema = schema_table.first;
-            transform(schema.begin(), schema.end(), schema.begin(), ::tolower);
+            try {
+                table_name_ = (const char *)sqlite3_value_text(argv[0]);
 
-            uint32_t data_version = UINT32_MAX;
-            int db_total_changes = INT_MAX;
-            bool main = schema.empty() || schema == "main.";
-            if (main) {
-                // cache levels for tables of the main database, invalidated when database changes
-                // are indicated by SQLITE_FCNTL_DATA_VERSION and/or sqlite3_total_changes().
-                // Exclude attached databases because we can't know if a schema name could have
-                // been reattached to a different file between invocations.
-                int rc =
-                    sqlite3_file_control(db_, nullptr, SQLITE_FCNTL_DATA_VERSION, &data_version);
-                if (rc != SQLITE_OK) {
-                    Error("genomic_range_index_levels(): error in SQLITE_FCNTL_DATA_VERSION");
-                    return rc;
+                if (argc >= 5) {
+                    if (sqlite3_value_type(argv[4]) == SQLITE_INTEGER) {
+                        ceiling_ = sqlite3_value_int(argv[4]);
+                    } else if (sqlite3_value_type(argv[4]) != SQLITE_NULL) {
+                        throw runtime_error("genomic_range_rowid_runs() expected integer ceiling");
+                    }
+                    if (argc >= 6) {
+                        if (sqlite3_value_type(argv[5]) == SQLITE_INTEGER) {
+                            floor_ = sqlite3_value_int(argv[5]);
+                        } else if (sqlite3_value_type(argv[5]) != SQLITE_NULL) {
+                            throw runtime_error("genomic_range_rowid_runs() expected integer floor");
+                        }
+                    }
                 }
-                db_total_changes = sqlite3_total_changes(db_);
-                auto cached = cache_.find(schema_table.second);
-                if (cached != cache_.end() && data_version == cached->second.data_version &&
-                    db_total_changes == cached->second.db_total_changes) {
-                    floor_ = cached->second.floor;
-                    ceiling_ = cached->second.ceiling;
-                    _DBG << "genomic_range_index_levels() cache hit on " << table_name
-                         << " ceiling = " << ceiling_ << " floor = " << floor_ << endl;
-                    return SQLITE_OK;
+                if (floor_ < 0 || ceiling_ > 15 || floor_ > ceiling_) {
+                    throw runtime_error("genomic_range_rowid_runs() ceiling/floor domain error");
                 }
-            }
 
-            try {
-                auto p = DetectLevelRange(db_, table_name);
-                floor_ = p.first;
-                ceiling_ = p.second;
-            } catch (std::exception &exn) {
-                Error(exn.what());
-                return SQLITE_ERROR;
-            }
-            assert(floor_ >= 0 && ceiling_ >= floor_ && ceiling_ <= 15);
+                // find or create the statement pool for (table, ceiling, floor)
+                auto &cache = stmt_cache_.Get(table_name_, ceiling_, floor_);
+                if (cache.pool.empty()) {
+                    string sql =
+                        GenomicRangeRowidsSQL(db_, table_name_, "?1", "?2", "?3", ceiling_, floor_);
+                    sql = sql.substr(1, sql.size() - 2); // trim parentheses
+                    sqlite3_stmt *pStmt = nullptr;
+                    if (sqlite3_prepare_v3(db_, sql.c_str(), -1, 0, &pStmt, nullptr) != SQLITE_OK) {
+                        throw runtime_error(
+                            "genomic_range_rowid_runs(): table doesn't exsit or lacks GRI; " +
+                            string(sqlite3_errmsg(db_)));
+                    }
+                    stmt_.reset(pStmt, sqlite3_finalize);
+                } else {
+                    stmt_ = cache.pool.back();
+                    cache.pool.pop_back();
+                }
 
-            if (main) {
-                auto cached = cache_.find(schema_table.second);
-                if (cached == cache_.end()) {
-                    cache_[schema_table.second] = cached_levels();
-                    cached = cache_.find(schema_table.second);
-                    assert(cached != cache_.end());
+                if (sqlite3_bind_value(stmt_.get(), 2, argv[2]) != SQLITE_OK ||
+                    sqlite3_bind_value(stmt_.get(), 3, argv[3]) != SQLITE_OK) {
+                    throw runtime_error("GenomicSQLite: error binding GRI query parameters");
                 }
-                cached->second.data_version = data_version;
-                cached->second.db_total_changes = db_total_changes;
-                cached->second.ceiling = ceiling_;
-                cached->second.floor = floor_;
+                if ((idxNum >> 1) & 1) {
+                    // qrid arrived as a batched IN value list: buffer the union of the per-rid
+                    // rowids, sort & dedup, then run-length compress the sorted whole (merged
+                    // sweep rationale as in GenomicRangeRowidsCursor)
+                    vector<sqlite3_int64> rowids;
+                    int rc =
+                        ForEachFilterValue(idxNum, 1, argv[1], [this, &rowids](sqlite3_value *qrid) {
+                            if (sqlite3_bind_value(stmt_.get(), 1, qrid) != SQLITE_OK) {
+                                return SQLITE_ERROR;
+                            }
+                            int rc2;
+                            while ((rc2 = sqlite3_step(stmt_.get())) == SQLITE_ROW) {
+                                rowids.push_back(sqlite3_column_int64(stmt_.get(), 0));
+                            }
+                            sqlite3_reset(stmt_.get());
+                            return rc2 == SQLITE_DONE ? SQLITE_OK : rc2;
+                        });
+                    if (rc != SQLITE_OK) {
+                        stmt_.reset();
+                        return rc;
+                    }
+                    sort(rowids.begin(), rowids.end());
+                    rowids.erase(unique(rowids.begin(), rowids.end()), rowids.end());
+                    for (auto rowid : rowids) {
+                        if (!drained_.empty() && rowid == drained_.back().second + 1) {
+                            drained_.back().second = rowid;
+                        } else {
+                            drained_.emplace_back(rowid, rowid);
+                        }
+                    }
+                    ReturnStmtToCache();
+                    replay_ = true;
+                    return SQLITE_OK;
+                }
+                if (sqlite3_bind_value(stmt_.get(), 1, argv[1]) != SQLITE_OK) {
+                    throw runtime_error("GenomicSQLite: error binding GRI query parameters");
+                }
+                if (web_) {
+                    return DrainRuns();
+                }
+                return Next(); // compress the first run
+            } catch (std::exception &exn) {
+                Error(exn.what());
             }
-
-            return SQLITE_OK;
         }
         return SQLITE_ERROR;
     }
 
     int Next() override {
-        ceiling_ = floor_ = -1;
+        if (replay_) {
+            ++drain_pos_;
+            return SQLITE_OK;
+        }
+        // begin the next run with the rowid that broke the previous one, if any
+        if (pending_valid_) {
+            run_first_ = run_last_ = pending_;
+            pending_valid_ = false;
+        } else {
+            if (!stmt_) {
+                have_run_ = false; // EOF
+                return SQLITE_OK;
+            }
+            int rc = sqlite3_step(stmt_.get());
+            if (rc != SQLITE_ROW) {
+                have_run_ = false;
+                if (rc != SQLITE_DONE) {
+                    assert(rc != SQLITE_OK);
+                    stmt_.reset();
+                    return rc;
+                }
+                ReturnStmtToCache(); // successful EOF
+                return SQLITE_OK;
+            }
+            run_first_ = run_last_ = sqlite3_column_int64(stmt_.get(), 0);
+        }
+        have_run_ = true;
+        ++run_count_;
+        // extend the run while the underlying rowids stay consecutive
+        while (stmt_) {
+            int rc = sqlite3_step(stmt_.get());
+            if (rc == SQLITE_ROW) {
+                sqlite3_int64 rowid = sqlite3_column_int64(stmt_.get(), 0);
+                if (rowid != run_last_ + 1) {
+                    pending_ = rowid;
+                    pending_valid_ = true;
+                    break;
+                }
+                run_last_ = rowid;
+            } else if (rc == SQLITE_DONE) {
+                ReturnStmtToCache();
+            } else {
+                assert(rc != SQLITE_OK);
+                stmt_.reset();
+                return rc;
+            }
+        }
         return SQLITE_OK;
     }
 
-    int Eof() override { return floor_ < 0; }
+    int Eof() override { return replay_ ? drain_pos_ >= drained_.size() : !have_run_; }
 
     int Column(sqlite3_context *ctx, int colno) override {
-        assert(floor_ >= 0 && ceiling_ >= floor_);
+        sqlite3_int64 first = replay_ ? drained_[drain_pos_].first : run_first_,
+                      last = replay_ ? drained_[drain_pos_].second : run_last_;
         switch (colno) {
         case 0:
-            sqlite3_result_int64(ctx, ceiling_);
+            sqlite3_result_int64(ctx, first);
             break;
         case 1:
-            sqlite3_result_int64(ctx, floor_);
+            sqlite3_result_int64(ctx, last);
             break;
         default:
             sqlite3_result_null(ctx);
@@ -969,35 +1753,80 @@ class GenomicRangeIndexLevelsCursor : public SQLiteVirtualTableCursor {
     }
 
     int Rowid(sqlite_int64 *pRowid) override {
-        assert(floor_ >= 0);
-        *pRowid = 1;
+        *pRowid = replay_ ? (sqlite3_int64)drain_pos_ + 1 : run_count_;
         return SQLITE_OK;
     }
 
   private:
     sqlite3 *db_;
-    levels_cache &cache_;
-    sqlite_int64 ceiling_ = -1, floor_ = -1;
+    GenomicRangeRowidsCursor::stmt_cache &stmt_cache_;
+    bool web_ = false;
+
+    shared_ptr<sqlite3_stmt> stmt_;
+    string table_name_;
+    int ceiling_ = 15, floor_ = 0;
+
+    sqlite3_int64 run_first_ = 0, run_last_ = 0, pending_ = 0, run_count_ = 0;
+    bool have_run_ = false, pending_valid_ = false;
+
+    // runs compressed eagerly at Filter() (web read-ahead, or batched-IN merged sweep), replayed
+    // by Next()/Column()
+    bool replay_ = false;
+    vector<pair<sqlite3_int64, sqlite3_int64>> drained_;
+    size_t drain_pos_ = 0;
+
+    int DrainRuns() {
+        drained_.clear();
+        drain_pos_ = 0;
+        replay_ = true;
+        int rc;
+        while ((rc = sqlite3_step(stmt_.get())) == SQLITE_ROW) {
+            sqlite3_int64 rowid = sqlite3_column_int64(stmt_.get(), 0);
+            if (!drained_.empty() && rowid == drained_.back().second + 1) {
+                drained_.back().second = rowid;
+            } else {
+                drained_.emplace_back(rowid, rowid);
+            }
+        }
+        if (rc != SQLITE_DONE) {
+            assert(rc != SQLITE_OK);
+            stmt_.reset();
+            return rc;
+        }
+        ReturnStmtToCache();
+        return SQLITE_OK;
+    }
+
+    void ReturnStmtToCache() {
+        if (stmt_) {
+            assert(floor_ >= 0 && ceiling_ >= floor_ && ceiling_ <= 15);
+            sqlite3_reset(stmt_.get());
+            stmt_cache_.Get(table_name_, ceiling_, floor_).pool.push_back(stmt_);
+            stmt_.reset();
+        }
+    }
 };
 
-class GenomicRangeIndexLevelsTVF : public SQLiteVirtualTable {
-    GenomicRangeIndexLevelsCursor::levels_cache cache_;
+class GenomicRangeRowidRunsTVF : public SQLiteVirtualTable {
+    // per-connection prepared-statement cache, as in GenomicRangeRowidsTVF (the underlying GRI
+    // query SQL is the same)
+    GenomicRangeRowidsCursor::stmt_cache stmt_cache_;
 
     unique_ptr<SQLiteVirtualTableCursor> NewCursor() override {
-        return unique_ptr<SQLiteVirtualTableCursor>(new GenomicRangeIndexLevelsCursor(db_, cache_));
+        return unique_ptr<SQLiteVirtualTableCursor>(
+            new GenomicRangeRowidRunsCursor(db_, stmt_cache_));
     }
 
   public:
-    GenomicRangeIndexLevelsTVF(sqlite3 *db) : SQLiteVirtualTable(db) {}
+    GenomicRangeRowidRunsTVF(sqlite3 *db) : SQLiteVirtualTable(db) {}
 
     int BestIndex(sqlite3_index_info *info) override {
-        int rc = BestIndexTVF(info, 2, 1, 1);
+        int rc = BestIndexTVF(info, 2, 4, 6, 1 << 1); // qrid may come as a batched IN list
         if (rc != SQLITE_OK)
             return rc;
-        info->orderByConsumed = 1;
-        info->estimatedCost = 1;
-        info->estimatedRows = 1;
-        info->idxFlags = SQLITE_INDEX_SCAN_UNIQUE;
+        info->orderByConsumed =
+            info->nOrderBy == 0 ||
+            (info->nOrderBy == 1 && info->aOrderBy[0].iColumn == 0 && !info->aOrderBy[0].desc);
         return SQLITE_OK;
     }
 
@@ -1005,74 +1834,680 @@ class GenomicRangeIndexLevelsTVF : public SQLiteVirtualTable {
                        sqlite3_vtab **ppVTab, char **pzErr) {
         return SQLiteVirtualTable::SimpleConnect(
             db, pAux, argc, argv, ppVTab, pzErr,
-            unique_ptr<SQLiteVirtualTable>(new GenomicRangeIndexLevelsTVF(db)),
-            "CREATE TABLE genomic_range_index_levels(_gri_ceiling INTEGER, _gri_floor INTEGER, tableName HIDDEN)");
+            unique_ptr<SQLiteVirtualTable>(new GenomicRangeRowidRunsTVF(db)),
+            "CREATE TABLE genomic_range_rowid_runs(first_rowid INTEGER, last_rowid INTEGER, tableName HIDDEN, qrid HIDDEN, qbeg HIDDEN, qend HIDDEN, ceiling HIDDEN, floor HIDDEN)");
     }
 };
 
-/**************************************************************************************************
- * reference sequence metadata (_gri_refseq) helpers
- **************************************************************************************************/
-
-static string gri_refseq_ddl(const string &schema) {
-    string schema_prefix;
-    if (!schema.empty()) {
-        schema_prefix = schema + ".";
+// compare two values consistently with SQLite ordering semantics (sans collations)
+static int compare_values(sqlite3_value *lhs, sqlite3_value *rhs) {
+    auto rank = [](sqlite3_value *v) {
+        switch (sqlite3_value_type(v)) {
+        case SQLITE_NULL:
+            return 0;
+        case SQLITE_INTEGER:
+        case SQLITE_FLOAT:
+            return 1;
+        case SQLITE_TEXT:
+            return 2;
+        default:
+            return 3;
+        }
+    };
+    int lr = rank(lhs), rr = rank(rhs);
+    if (lr != rr) {
+        return lr < rr ? -1 : 1;
     }
-    ostringstream out;
-    out << "CREATE TABLE IF NOT EXISTS " << schema_prefix << "_gri_refseq"
-        << "(_gri_rid INTEGER NOT NULL PRIMARY KEY, gri_refseq_name TEXT NOT NULL, gri_assembly TEXT,"
-        << " gri_refget_id TEXT UNIQUE, gri_refseq_length INTEGER NOT NULL, gri_refseq_meta_json TEXT NOT NULL DEFAULT '{}', "
-        << "UNIQUE(gri_assembly,gri_refseq_name))"
-        << ";\nCREATE INDEX IF NOT EXISTS " << schema_prefix << "_gri_refseq_name ON "
-        << "_gri_refseq(gri_refseq_name)";
-    return out.str();
-}
-
-string PutGenomicReferenceSequenceSQL(const string &name, sqlite3_int64 length,
-                                      const string &assembly, const string &refget_id,
-                                      const string &meta_json, sqlite3_int64 rid,
-                                      const string &schema, bool with_ddl) {
-    string schema_prefix;
-    if (!schema.empty()) {
-        schema_prefix = schema + ".";
+    switch (lr) {
+    case 0:
+        return 0;
+    case 1: {
+        double l = sqlite3_value_double(lhs), r = sqlite3_value_double(rhs);
+        return l < r ? -1 : (l > r ? 1 : 0);
+    }
+    default: {
+        int lsz = sqlite3_value_bytes(lhs), rsz = sqlite3_value_bytes(rhs);
+        if (min(lsz, rsz) == 0) { // sqlite3_value_blob() of a zero-length BLOB is NULL
+            return lsz < rsz ? -1 : (lsz > rsz ? 1 : 0);
+        }
+        const void *lp = lr == 2 ? (const void *)sqlite3_value_text(lhs) : sqlite3_value_blob(lhs),
+                   *rp = lr == 2 ? (const void *)sqlite3_value_text(rhs) : sqlite3_value_blob(rhs);
+        int c = memcmp(lp, rp, min(lsz, rsz));
+        return c != 0 ? c : (lsz < rsz ? -1 : (lsz > rsz ? 1 : 0));
     }
-    ostringstream out;
-    if (with_ddl) {
-        out << gri_refseq_ddl(schema) << ";\n";
     }
-    out << "INSERT INTO " << schema_prefix
-        << "_gri_refseq(_gri_rid,gri_refseq_name,gri_assembly,gri_refget_id,gri_refseq_length,gri_refseq_meta_json) VALUES("
-        << (rid >= 0 ? std::to_string(rid) : "NULL") << "," << sqlquote(name) << ","
-        << (assembly.empty() ? "NULL" : sqlquote(assembly)) << ","
-        << (refget_id.empty() ? "NULL" : sqlquote(refget_id)) << "," << std::to_string(length)
-        << "," << sqlquote(meta_json.empty() ? string("{}") : meta_json) << ")";
-    return out.str();
-}
-
-string PutGenomicReferenceSequenceSQL(const string &name, sqlite3_int64 length,
-                                      const string &assembly, const string &refget_id,
-                                      const string &meta_json, sqlite3_int64 rid,
-                                      const string &schema) {
-    return PutGenomicReferenceSequenceSQL(name, length, assembly, refget_id, meta_json, rid, schema,
-                                          true);
 }
 
-extern "C" char *put_genomic_reference_sequence_sql(const char *name, sqlite3_int64 length,
-                                                    const char *assembly, const char *refget_id,
-                                                    const char *meta_json, sqlite3_int64 rid,
-                                                    const char *schema) {
-    C_WRAPPER(PutGenomicReferenceSequenceSQL(
-        name, length, assembly ? assembly : "", refget_id ? refget_id : "",
-        meta_json ? meta_json : "{}", rid, schema ? schema : "", true));
-}
+// genomic_range_rowids_batch(tableName, rangesTable[, ceiling [, floor]]): batched form of
+// genomic_range_rowids() for joining a large set of query ranges against one GRI-indexed table.
+// rangesTable names any table, view, or TVF (e.g. a bound temp table or carray) whose first three
+// columns provide (qrid, qbeg, qend). The cursor slurps & sorts the ranges once, then streams
+// (query_ordinal, _rowid_) pairs through a single prepared GRI statement, amortizing the
+// per-range Filter()/prepare/bind overhead that dominates joins of millions of ranges.
+// query_ordinal is the 1-based position of each range in rangesTable's natural scan order.
+// Unlike genomic_range_rowids(), omitted ceiling & floor default to automatic detection, whose
+// upfront cost is worthwhile for a large batch.
+class GenomicRangeRowidsBatchCursor : public SQLiteVirtualTableCursor {
+  public:
+    GenomicRangeRowidsBatchCursor(sqlite3 *db) : db_(db) {}
+    virtual ~GenomicRangeRowidsBatchCursor() { ClearRanges(); }
 
-static void sqlfn_put_genomic_reference_sequence_sql(sqlite3_context *ctx, int argc,
-                                                     sqlite3_value **argv) {
-    string name, assembly, refget_id, meta_json = "{}", schema;
-    sqlite3_int64 length, rid = -1;
-    assert(argc >= 2 && argc <= 7);
-    ARG_TEXT(name, 0)
+    int Filter(int idxNum, const char *idxStr, int argc, sqlite3_value **argv) override {
+        ClearRanges();
+        stmt_.reset();
+        range_ = 0;
+        count_ = 0;
+        if (argc < 2 || argc > 4) {
+            Error("genomic_range_rowids_batch() expects 2-4 arguments");
+        } else if (sqlite3_value_type(argv[0]) != SQLITE_TEXT) {
+            Error("genomic_range_rowids_batch() argument 1 should be the GRI-indexed table name");
+        } else if (sqlite3_value_type(argv[1]) != SQLITE_TEXT) {
+            Error("genomic_range_rowids_batch() argument 2 should be the query ranges table name");
+        } else {
+            try {
+                string table_name = (const char *)sqlite3_value_text(argv[0]),
+                       ranges_table = (const char *)sqlite3_value_text(argv[1]);
+                // TODO: sanitize table names
+                sqlite3_int64 ceiling = -1, floor = -1;
+                if (argc >= 3) {
+                    if (sqlite3_value_type(argv[2]) == SQLITE_INTEGER) {
+                        ceiling = sqlite3_value_int64(argv[2]);
+                    } else if (sqlite3_value_type(argv[2]) != SQLITE_NULL) {
+                        throw runtime_error("genomic_range_rowids_batch() expected integer ceiling");
+                    }
+                    if (argc >= 4) {
+                        if (sqlite3_value_type(argv[3]) == SQLITE_INTEGER) {
+                            floor = sqlite3_value_int64(argv[3]);
+                        } else if (sqlite3_value_type(argv[3]) != SQLITE_NULL) {
+                            throw runtime_error("genomic_range_rowids_batch() expected integer floor");
+                        }
+                    }
+                }
+
+                SlurpRanges(ranges_table);
+
+                // prepare one sqlite3_stmt for the GRI query, reused across all ranges
+                string sql =
+                    GenomicRangeRowidsSQL(db_, table_name, "?1", "?2", "?3", ceiling, floor);
+                sql = sql.substr(1, sql.size() - 2); // trim parentheses
+                sqlite3_stmt *pStmt = nullptr;
+                if (sqlite3_prepare_v3(db_, sql.c_str(), -1, 0, &pStmt, nullptr) != SQLITE_OK) {
+                    throw runtime_error(
+                        "genomic_range_rowids_batch(): table doesn't exist or lacks GRI; " +
+                        string(sqlite3_errmsg(db_)));
+                }
+                stmt_.reset(pStmt, sqlite3_finalize);
+
+                return NextRange(); // bind first range & step to first result row
+            } catch (std::exception &exn) {
+                Error(exn.what());
+            }
+        }
+        return SQLITE_ERROR;
+    }
+
+    int Next() override {
+        if (stmt_) {
+            int rc = sqlite3_step(stmt_.get());
+            if (rc == SQLITE_ROW) {
+                ++count_;
+            } else if (rc == SQLITE_DONE) {
+                ++range_;
+                return NextRange();
+            } else {
+                assert(rc != SQLITE_OK);
+                stmt_.reset();
+                return rc;
+            }
+        }
+        return SQLITE_OK;
+    }
+
+    int Eof() override { return !stmt_; }
+
+    int Column(sqlite3_context *ctx, int colno) override {
+        assert(stmt_ && range_ < ranges_.size());
+        if (!stmt_)
+            return SQLITE_ERROR;
+        switch (colno) {
+        case 0:
+            sqlite3_result_int64(ctx, ranges_[range_].ordinal);
+            break;
+        case 1:
+            sqlite3_result_value(ctx, sqlite3_column_value(stmt_.get(), 0));
+            break;
+        default:
+            sqlite3_result_null(ctx);
+        }
+        return SQLITE_OK;
+    }
+
+    int Rowid(sqlite_int64 *pRowid) override {
+        *pRowid = count_;
+        return SQLITE_OK;
+    }
+
+  private:
+    struct query_range {
+        sqlite3_value *rid = nullptr, *beg = nullptr, *end = nullptr;
+        sqlite3_int64 ordinal = 0;
+    };
+
+    sqlite3 *db_;
+    shared_ptr<sqlite3_stmt> stmt_;
+    vector<query_range> ranges_;
+    size_t range_ = 0;
+    sqlite3_int64 count_ = 0;
+
+    void ClearRanges() {
+        for (auto &r : ranges_) {
+            sqlite3_value_free(r.rid);
+            sqlite3_value_free(r.beg);
+            sqlite3_value_free(r.end);
+        }
+        ranges_.clear();
+    }
+
+    // read (qrid, qbeg, qend) from the first three columns of the named table & sort by
+    // (qrid, qbeg) so that the subsequent GRI probes sweep the index roughly in order
+    void SlurpRanges(const string &ranges_table) {
+        string sql = "SELECT * FROM " + ranges_table;
+        shared_ptr<sqlite3_stmt> slurp;
+        {
+            sqlite3_stmt *pStmt = nullptr;
+            if (sqlite3_prepare_v3(db_, sql.c_str(), -1, 0, &pStmt, nullptr) != SQLITE_OK) {
+                throw runtime_error("genomic_range_rowids_batch(): can't read query ranges; " +
+                                    string(sqlite3_errmsg(db_)));
+            }
+            slurp = shared_ptr<sqlite3_stmt>(pStmt, sqlite3_finalize);
+        }
+        if (sqlite3_column_count(slurp.get()) < 3) {
+            throw runtime_error(
+                "genomic_range_rowids_batch(): query ranges table needs >= 3 columns");
+        }
+        int rc;
+        while ((rc = sqlite3_step(slurp.get())) == SQLITE_ROW) {
+            query_range r;
+            r.ordinal = (sqlite3_int64)ranges_.size() + 1;
+            if (!(r.rid = sqlite3_value_dup(sqlite3_column_value(slurp.get(), 0))) ||
+                !(r.beg = sqlite3_value_dup(sqlite3_column_value(slurp.get(), 1))) ||
+                !(r.end = sqlite3_value_dup(sqlite3_column_value(slurp.get(), 2)))) {
+                sqlite3_value_free(r.rid);
+                sqlite3_value_free(r.beg);
+                sqlite3_value_free(r.end);
+                throw std::bad_alloc();
+            }
+            ranges_.push_back(r);
+        }
+        if (rc != SQLITE_DONE) {
+            throw runtime_error("genomic_range_rowids_batch(): error reading query ranges; " +
+                                string(sqlite3_errmsg(db_)));
+        }
+        stable_sort(ranges_.begin(), ranges_.end(),
+                    [](const query_range &lhs, const query_range &rhs) {
+                        int c = compare_values(lhs.rid, rhs.rid);
+                        return c != 0 ? c < 0 : compare_values(lhs.beg, rhs.beg) < 0;
+                    });
+    }
+
+    // bind the current range (skipping any that prove empty) & step to its first result row;
+    // leaves stmt_ null at the end of the batch
+    int NextRange() {
+        while (stmt_ && range_ < ranges_.size()) {
+            const query_range &r = ranges_[range_];
+            if (sqlite3_reset(stmt_.get()) != SQLITE_OK ||
+                sqlite3_bind_value(stmt_.get(), 1, r.rid) != SQLITE_OK ||
+                sqlite3_bind_value(stmt_.get(), 2, r.beg) != SQLITE_OK ||
+                sqlite3_bind_value(stmt_.get(), 3, r.end) != SQLITE_OK) {
+                Error("GenomicSQLite: error binding GRI query parameters");
+                return SQLITE_ERROR;
+            }
+            int rc = sqlite3_step(stmt_.get());
+            if (rc == SQLITE_ROW) {
+                ++count_;
+                return SQLITE_OK;
+            } else if (rc != SQLITE_DONE) {
+                assert(rc != SQLITE_OK);
+                stmt_.reset();
+                return rc;
+            }
+            ++range_; // range had no results
+        }
+        stmt_.reset(); // successful EOF
+        return SQLITE_OK;
+    }
+};
+
+class GenomicRangeRowidsBatchTVF : public SQLiteVirtualTable {
+    unique_ptr<SQLiteVirtualTableCursor> NewCursor() override {
+        return unique_ptr<SQLiteVirtualTableCursor>(new GenomicRangeRowidsBatchCursor(db_));
+    }
+
+  public:
+    GenomicRangeRowidsBatchTVF(sqlite3 *db) : SQLiteVirtualTable(db) {}
+
+    int BestIndex(sqlite3_index_info *info) override { return BestIndexTVF(info, 2, 2, 4); }
+
+    static int Connect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
+                       sqlite3_vtab **ppVTab, char **pzErr) {
+        return SQLiteVirtualTable::SimpleConnect(
+            db, pAux, argc, argv, ppVTab, pzErr,
+            unique_ptr<SQLiteVirtualTable>(new GenomicRangeRowidsBatchTVF(db)),
+            "CREATE TABLE genomic_range_rowids_batch(query_ordinal INTEGER, _rowid_ INTEGER, tableName HIDDEN, rangesTable HIDDEN, ceiling HIDDEN, floor HIDDEN)");
+    }
+};
+
+// genomic_range_join(leftTable, rightTable): stream all overlapping pairs between two
+// GRI-indexed tables as (left_rowid, right_rowid), replacing the nested per-row
+// genomic_range_rowids() pattern (which re-descends the right table's __gri b-tree for every
+// left row) with a single coordinated plane-sweep. Each table is scanned once in
+// (_gri_rid, _gri_beg) order -- SQLite's sorter produces that order from the GRI's virtual
+// columns -- and a linear merge maintains the set of intervals "active" at the sweep point,
+// emitting a pair whenever a new interval arrives while one from the other table is active.
+// Overlap semantics match genomic_range_rowids(): abutting intervals count as overlapping, and
+// rows with NULL coordinates never match.
+class GenomicRangeJoinCursor : public SQLiteVirtualTableCursor {
+  public:
+    GenomicRangeJoinCursor(sqlite3 *db) : db_(db) {}
+    virtual ~GenomicRangeJoinCursor() { sqlite3_value_free(sweep_rid_); }
+
+    int Filter(int idxNum, const char *idxStr, int argc, sqlite3_value **argv) override {
+        for (int s = 0; s < 2; ++s) {
+            streams_[s].stmt.reset();
+            streams_[s].eof = true;
+            active_[s].clear();
+        }
+        sqlite3_value_free(sweep_rid_);
+        sweep_rid_ = nullptr;
+        pend_side_ = -1;
+        eof_ = false;
+        count_ = 0;
+        if (argc != 2) {
+            Error("genomic_range_join() expects 2 arguments");
+        } else if (sqlite3_value_type(argv[0]) != SQLITE_TEXT ||
+                   sqlite3_value_type(argv[1]) != SQLITE_TEXT) {
+            Error("genomic_range_join() expects two GRI-indexed table names");
+        } else {
+            try {
+                for (int s = 0; s < 2; ++s) {
+                    string table = (const char *)sqlite3_value_text(argv[s]);
+                    // TODO: sanitize table name
+                    string sql = "SELECT _rowid_, _gri_rid, _gri_beg, _gri_beg+_gri_len FROM " +
+                                 table +
+                                 " WHERE _gri_lvl IS NOT NULL ORDER BY _gri_rid, _gri_beg";
+                    sqlite3_stmt *pStmt = nullptr;
+                    if (sqlite3_prepare_v3(db_, sql.c_str(), -1, 0, &pStmt, nullptr) !=
+                        SQLITE_OK) {
+                        throw runtime_error(
+                            "genomic_range_join(): table is probably missing genomic range index; " +
+                            string(sqlite3_errmsg(db_)));
+                    }
+                    streams_[s].stmt = shared_ptr<sqlite3_stmt>(pStmt, sqlite3_finalize);
+                }
+                int rc;
+                if ((rc = StepStream(0)) != SQLITE_OK || (rc = StepStream(1)) != SQLITE_OK) {
+                    return rc;
+                }
+                return Next(); // sweep to first overlapping pair
+            } catch (std::exception &exn) {
+                Error(exn.what());
+            }
+        }
+        return SQLITE_ERROR;
+    }
+
+    int Next() override {
+        if (eof_) {
+            return SQLITE_OK;
+        }
+        if (pend_side_ >= 0) {
+            ++pend_idx_;
+        }
+        while (pend_side_ < 0 || pend_idx_ >= active_[1 - pend_side_].size()) {
+            int rc = Advance();
+            if (rc != SQLITE_OK || eof_) {
+                return rc;
+            }
+        }
+        ++count_;
+        return SQLITE_OK;
+    }
+
+    int Eof() override { return eof_; }
+
+    int Column(sqlite3_context *ctx, int colno) override {
+        assert(!eof_ && pend_side_ >= 0 && pend_idx_ < active_[1 - pend_side_].size());
+        switch (colno) {
+        case 0:
+            sqlite3_result_int64(ctx, pend_side_ == 0 ? pend_rowid_
+                                                      : active_[0][pend_idx_].rowid);
+            break;
+        case 1:
+            sqlite3_result_int64(ctx, pend_side_ == 1 ? pend_rowid_
+                                                      : active_[1][pend_idx_].rowid);
+            break;
+        default:
+            sqlite3_result_null(ctx);
+        }
+        return SQLITE_OK;
+    }
+
+    int Rowid(sqlite_int64 *pRowid) override {
+        *pRowid = count_;
+        return SQLITE_OK;
+    }
+
+  private:
+    struct active_iv {
+        sqlite3_int64 end, rowid;
+    };
+    struct stream {
+        shared_ptr<sqlite3_stmt> stmt;
+        bool eof = true;
+    };
+
+    sqlite3 *db_;
+    stream streams_[2];
+    vector<active_iv> active_[2];
+    sqlite3_value *sweep_rid_ = nullptr; // rid of the current sweep position (nullptr = none yet)
+    int pend_side_ = -1;                 // side of the newest interval, whose pairs we're emitting
+    sqlite3_int64 pend_rowid_ = 0;
+    size_t pend_idx_ = 0;
+    bool eof_ = true;
+    sqlite3_int64 count_ = 0;
+
+    int StepStream(int s) {
+        int rc = sqlite3_step(streams_[s].stmt.get());
+        if (rc == SQLITE_ROW) {
+            streams_[s].eof = false;
+        } else if (rc == SQLITE_DONE) {
+            streams_[s].eof = true;
+        } else {
+            assert(rc != SQLITE_OK);
+            streams_[s].stmt.reset();
+            streams_[s].eof = true;
+            return rc;
+        }
+        return SQLITE_OK;
+    }
+
+    // consume the stream whose current interval is next in (_gri_rid, _gri_beg) order, adding it
+    // to its active list and setting up emission of its pairs with the other side's active list
+    int Advance() {
+        int s;
+        if (streams_[0].eof && streams_[1].eof) {
+            eof_ = true;
+            return SQLITE_OK;
+        } else if (streams_[0].eof || streams_[1].eof) {
+            s = streams_[0].eof ? 1 : 0;
+        } else {
+            int c = compare_values(sqlite3_column_value(streams_[0].stmt.get(), 1),
+                                   sqlite3_column_value(streams_[1].stmt.get(), 1));
+            if (c == 0) {
+                c = sqlite3_column_int64(streams_[0].stmt.get(), 2) <=
+                            sqlite3_column_int64(streams_[1].stmt.get(), 2)
+                        ? -1
+                        : 1;
+            }
+            s = c <= 0 ? 0 : 1;
+        }
+        sqlite3_stmt *row = streams_[s].stmt.get();
+        sqlite3_value *rid = sqlite3_column_value(row, 1);
+        sqlite3_int64 beg = sqlite3_column_int64(row, 2), end = sqlite3_column_int64(row, 3),
+                      rowid = sqlite3_column_int64(row, 0);
+
+        if (!sweep_rid_ || compare_values(rid, sweep_rid_) != 0) {
+            // sweep moves to a new rid: no prior intervals remain relevant
+            active_[0].clear();
+            active_[1].clear();
+            sqlite3_value_free(sweep_rid_);
+            if (!(sweep_rid_ = sqlite3_value_dup(rid))) {
+                throw std::bad_alloc();
+            }
+        } else {
+            // prune intervals that end before the sweep position; they can't overlap this or any
+            // future interval (whose begs are >= beg)
+            for (int side = 0; side < 2; ++side) {
+                auto &actives = active_[side];
+                actives.erase(remove_if(actives.begin(), actives.end(),
+                                        [beg](const active_iv &iv) { return iv.end < beg; }),
+                              actives.end());
+            }
+        }
+        active_[s].push_back(active_iv{end, rowid});
+
+        // everything remaining active on the other side overlaps the new interval
+        pend_side_ = s;
+        pend_rowid_ = rowid;
+        pend_idx_ = 0;
+        return StepStream(s);
+    }
+};
+
+class GenomicRangeJoinTVF : public SQLiteVirtualTable {
+    unique_ptr<SQLiteVirtualTableCursor> NewCursor() override {
+        return unique_ptr<SQLiteVirtualTableCursor>(new GenomicRangeJoinCursor(db_));
+    }
+
+  public:
+    GenomicRangeJoinTVF(sqlite3 *db) : SQLiteVirtualTable(db) {}
+
+    int BestIndex(sqlite3_index_info *info) override { return BestIndexTVF(info, 2, 2, 2); }
+
+    static int Connect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
+                       sqlite3_vtab **ppVTab, char **pzErr) {
+        return SQLiteVirtualTable::SimpleConnect(
+            db, pAux, argc, argv, ppVTab, pzErr,
+            unique_ptr<SQLiteVirtualTable>(new GenomicRangeJoinTVF(db)),
+            "CREATE TABLE genomic_range_join(left_rowid INTEGER, right_rowid INTEGER, leftTable HIDDEN, rightTable HIDDEN)");
+    }
+};
+
+// genomic_range_index_levels(tableName): inspect the GRI to detect the gri_ceiling and gri_floor
+// of the (current snapshot of) the given table. (returns just one row)
+class GenomicRangeIndexLevelsCursor : public SQLiteVirtualTableCursor {
+  public:
+    struct cached_levels {
+        uint32_t data_version = UINT32_MAX;
+        int db_total_changes = INT_MAX, ceiling = 15, floor = 0;
+    };
+    using levels_cache = map<string, cached_levels>;
+    GenomicRangeIndexLevelsCursor(sqlite3 *db, levels_cache &cache) : db_(db), cache_(cache) {}
+
+    int Filter(int idxNum, const char *idxStr, int argc, sqlite3_value **argv) override {
+        ceiling_ = floor_ = -1;
+        if (argc != 1) {
+            Error("genomic_range_index_levels() expects 1 argument");
+        } else if (sqlite3_value_type(argv[0]) != SQLITE_TEXT) {
+            Error("genomic_range_index_levels() expects table name");
+        } else {
+            string table_name = (const char *)sqlite3_value_text(argv[0]);
+            // TODO: sanitize table_name
+            auto schema_table = split_schema_table(table_name);
+            string schema = schema_table.first;
+            transform(schema.begin(), schema.end(), schema.begin(), ::tolower);
+
+            uint32_t data_version = UINT32_MAX;
+            int db_total_changes = INT_MAX;
+            bool main = schema.empty() || schema == "main.";
+            if (main) {
+                // cache levels for tables of the main database, invalidated when database changes
+                // are indicated by SQLITE_FCNTL_DATA_VERSION and/or sqlite3_total_changes().
+                // Exclude attached databases because we can't know if a schema name could have
+                // been reattached to a different file between invocations.
+                int rc =
+                    sqlite3_file_control(db_, nullptr, SQLITE_FCNTL_DATA_VERSION, &data_version);
+                if (rc != SQLITE_OK) {
+                    Error("genomic_range_index_levels(): error in SQLITE_FCNTL_DATA_VERSION");
+                    return rc;
+                }
+                db_total_changes = sqlite3_total_changes(db_);
+                auto cached = cache_.find(schema_table.second);
+                if (cached != cache_.end() && data_version == cached->second.data_version &&
+                    db_total_changes == cached->second.db_total_changes) {
+                    floor_ = cached->second.floor;
+                    ceiling_ = cached->second.ceiling;
+                    _DBG << "genomic_range_index_levels() cache hit on " << table_name
+                         << " ceiling = " << ceiling_ << " floor = " << floor_ << endl;
+                    return SQLITE_OK;
+                }
+            }
+
+            try {
+                auto p = DetectLevelRange(db_, table_name);
+                floor_ = p.first;
+                ceiling_ = p.second;
+            } catch (std::exception &exn) {
+                Error(exn.what());
+                return SQLITE_ERROR;
+            }
+            assert(floor_ >= 0 && ceiling_ >= floor_ && ceiling_ <= 15);
+
+            if (main) {
+                auto cached = cache_.find(schema_table.second);
+                if (cached == cache_.end()) {
+                    cache_[schema_table.second] = cached_levels();
+                    cached = cache_.find(schema_table.second);
+                    assert(cached != cache_.end());
+                }
+                cached->second.data_version = data_version;
+                cached->second.db_total_changes = db_total_changes;
+                cached->second.ceiling = ceiling_;
+                cached->second.floor = floor_;
+            }
+
+            return SQLITE_OK;
+        }
+        return SQLITE_ERROR;
+    }
+
+    int Next() override {
+        ceiling_ = floor_ = -1;
+        return SQLITE_OK;
+    }
+
+    int Eof() override { return floor_ < 0; }
+
+    int Column(sqlite3_context *ctx, int colno) override {
+        assert(floor_ >= 0 && ceiling_ >= floor_);
+        switch (colno) {
+        case 0:
+            sqlite3_result_int64(ctx, ceiling_);
+            break;
+        case 1:
+            sqlite3_result_int64(ctx, floor_);
+            break;
+        default:
+            sqlite3_result_null(ctx);
+        }
+        return SQLITE_OK;
+    }
+
+    int Rowid(sqlite_int64 *pRowid) override {
+        assert(floor_ >= 0);
+        *pRowid = 1;
+        return SQLITE_OK;
+    }
+
+  private:
+    sqlite3 *db_;
+    levels_cache &cache_;
+    sqlite_int64 ceiling_ = -1, floor_ = -1;
+};
+
+class GenomicRangeIndexLevelsTVF : public SQLiteVirtualTable {
+    GenomicRangeIndexLevelsCursor::levels_cache cache_;
+
+    unique_ptr<SQLiteVirtualTableCursor> NewCursor() override {
+        return unique_ptr<SQLiteVirtualTableCursor>(new GenomicRangeIndexLevelsCursor(db_, cache_));
+    }
+
+  public:
+    GenomicRangeIndexLevelsTVF(sqlite3 *db) : SQLiteVirtualTable(db) {}
+
+    int BestIndex(sqlite3_index_info *info) override {
+        int rc = BestIndexTVF(info, 2, 1, 1);
+        if (rc != SQLITE_OK)
+            return rc;
+        info->orderByConsumed = 1;
+        info->estimatedCost = 1;
+        info->estimatedRows = 1;
+        info->idxFlags = SQLITE_INDEX_SCAN_UNIQUE;
+        return SQLITE_OK;
+    }
+
+    static int Connect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
+                       sqlite3_vtab **ppVTab, char **pzErr) {
+        return SQLiteVirtualTable::SimpleConnect(
+            db, pAux, argc, argv, ppVTab, pzErr,
+            unique_ptr<SQLiteVirtualTable>(new GenomicRangeIndexLevelsTVF(db)),
+            "CREATE TABLE genomic_range_index_levels(_gri_ceiling INTEGER, _gri_floor INTEGER, tableName HIDDEN)");
+    }
+};
+
+/**************************************************************************************************
+ * reference sequence metadata (_gri_refseq) helpers
+ **************************************************************************************************/
+
+static string gri_refseq_ddl(const string &schema) {
+    string schema_prefix;
+    if (!schema.empty()) {
+        schema_prefix = schema + ".";
+    }
+    ostringstream out;
+    out << "CREATE TABLE IF NOT EXISTS " << schema_prefix << "_gri_refseq"
+        << "(_gri_rid INTEGER NOT NULL PRIMARY KEY, gri_refseq_name TEXT NOT NULL, gri_assembly TEXT,"
+        << " gri_refget_id TEXT UNIQUE, gri_refseq_length INTEGER NOT NULL, gri_refseq_meta_json TEXT NOT NULL DEFAULT '{}', "
+        << "UNIQUE(gri_assembly,gri_refseq_name))"
+        << ";\nCREATE INDEX IF NOT EXISTS " << schema_prefix << "_gri_refseq_name ON "
+        << "_gri_refseq(gri_refseq_name)";
+    return out.str();
+}
+
+string PutGenomicReferenceSequenceSQL(const string &name, sqlite3_int64 length,
+                                      const string &assembly, const string &refget_id,
+                                      const string &meta_json, sqlite3_int64 rid,
+                                      const string &schema, bool with_ddl) {
+    string schema_prefix;
+    if (!schema.empty()) {
+        schema_prefix = schema + ".";
+    }
+    ostringstream out;
+    if (with_ddl) {
+        out << gri_refseq_ddl(schema) << ";\n";
+    }
+    out << "INSERT INTO " << schema_prefix
+        << "_gri_refseq(_gri_rid,gri_refseq_name,gri_assembly,gri_refget_id,gri_refseq_length,gri_refseq_meta_json) VALUES("
+        << (rid >= 0 ? std::to_string(rid) : "NULL") << "," << sqlquote(name) << ","
+        << (assembly.empty() ? "NULL" : sqlquote(assembly)) << ","
+        << (refget_id.empty() ? "NULL" : sqlquote(refget_id)) << "," << std::to_string(length)
+        << "," << sqlquote(meta_json.empty() ? string("{}") : meta_json) << ")";
+    return out.str();
+}
+
+string PutGenomicReferenceSequenceSQL(const string &name, sqlite3_int64 length,
+                                      const string &assembly, const string &refget_id,
+                                      const string &meta_json, sqlite3_int64 rid,
+                                      const string &schema) {
+    return PutGenomicReferenceSequenceSQL(name, length, assembly, refget_id, meta_json, rid, schema,
+                                          true);
+}
+
+extern "C" char *put_genomic_reference_sequence_sql(const char *name, sqlite3_int64 length,
+                                                    const char *assembly, const char *refget_id,
+                                                    const char *meta_json, sqlite3_int64 rid,
+                                                    const char *schema) {
+    C_WRAPPER(PutGenomicReferenceSequenceSQL(
+        name, length, assembly ? assembly : "", refget_id ? refget_id : "",
+        meta_json ? meta_json : "{}", rid, schema ? schema : "", true));
+}
+
+static void sqlfn_put_genomic_reference_sequence_sql(sqlite3_context *ctx, int argc,
+                                                     sqlite3_value **argv) {
+    string name, assembly, refget_id, meta_json = "{}", schema;
+    sqlite3_int64 length, rid = -1;
+    assert(argc >= 2 && argc <= 7);
+    ARG_TEXT(name, 0)
     ARG(length, 1, SQLITE_INTEGER, int64)
     ARG_TEXT_OPTIONAL(assembly, 2)
     ARG_TEXT_OPTIONAL(refget_id, 3)
@@ -1083,508 +2518,1748 @@ static void sqlfn_put_genomic_reference_sequence_sql(sqlite3_context *ctx, int a
         PutGenomicReferenceSequenceSQL(name, length, assembly, refget_id, meta_json, rid, schema))
 }
 
-string PutGenomicReferenceAssemblySQL(const string &assembly, const string &schema) {
-    const hardcoded_refseq_t *hardcoded_refseqs = nullptr;
-    size_t nr_hardcoded_refseqs = 0;
-    if (assembly == "GRCh38_no_alt_analysis_set") {
-        hardcoded_refseqs = GRCh38_no_alt_analysis_set;
-        nr_hardcoded_refseqs = sizeof(GRCh38_no_alt_analysis_set) / sizeof(hardcoded_refseq_t);
-    } else {
-        throw std::invalid_argument("put_genomic_reference_assembly_sql: unknown assembly");
+string PutGenomicReferenceAssemblySQL(const string &assembly, const string &schema) {
+    const hardcoded_refseq_t *hardcoded_refseqs = nullptr;
+    size_t nr_hardcoded_refseqs = 0;
+    if (assembly == "GRCh38_no_alt_analysis_set") {
+        hardcoded_refseqs = GRCh38_no_alt_analysis_set;
+        nr_hardcoded_refseqs = sizeof(GRCh38_no_alt_analysis_set) / sizeof(hardcoded_refseq_t);
+    } else {
+        throw std::invalid_argument("put_genomic_reference_assembly_sql: unknown assembly");
+    }
+    ostringstream out;
+    for (size_t i = 0; i < nr_hardcoded_refseqs; ++i) {
+        if (i) {
+            out << ";\n";
+        }
+        const hardcoded_refseq_t &hcrs = hardcoded_refseqs[i];
+        out << PutGenomicReferenceSequenceSQL(string(hcrs.name), hcrs.length, assembly,
+                                              hcrs.refget_id ? string(hcrs.refget_id) : string(),
+                                              string("{}"), -1, schema, i == 0);
+    }
+    return out.str();
+}
+
+extern "C" char *put_genomic_reference_assembly_sql(const char *assembly, const char *schema) {
+    C_WRAPPER(PutGenomicReferenceAssemblySQL(string(assembly), schema ? schema : ""));
+}
+
+static void sqlfn_put_genomic_reference_assembly_sql(sqlite3_context *ctx, int argc,
+                                                     sqlite3_value **argv) {
+    string assembly, schema;
+    assert(argc == 1 || argc == 2);
+    ARG_TEXT(assembly, 0)
+    ARG_TEXT_OPTIONAL(schema, 1)
+    SQL_WRAPPER(PutGenomicReferenceAssemblySQL(assembly, schema))
+}
+
+map<long long, gri_refseq_t>
+GetGenomicReferenceSequencesByRid(sqlite3 *dbconn, const string &assembly, const string &schema) {
+    map<long long, gri_refseq_t> ans;
+    string schema_prefix = schema.empty() ? "" : (schema + ".");
+
+    string query =
+        "SELECT _gri_rid, gri_refseq_name, gri_refseq_length, gri_assembly, gri_refget_id, gri_refseq_meta_json FROM " +
+        schema_prefix + "_gri_refseq";
+    if (!assembly.empty()) {
+        query += " WHERE gri_assembly = ?";
+    }
+    shared_ptr<sqlite3_stmt> stmt;
+    {
+        sqlite3_stmt *pStmt = nullptr;
+        if (sqlite3_prepare_v3(dbconn, query.c_str(), -1, 0, &pStmt, nullptr) != SQLITE_OK) {
+            throw runtime_error("GenomicSQLite: error querying reference sequences");
+        }
+        stmt = shared_ptr<sqlite3_stmt>(pStmt, sqlite3_finalize);
+    }
+    if (!assembly.empty()) {
+        if (sqlite3_bind_text(stmt.get(), 1, assembly.c_str(), -1, nullptr) != SQLITE_OK) {
+            throw runtime_error("GenomicSQLite: error querying reference sequences");
+        }
+    }
+    int rc;
+    while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
+        gri_refseq_t item;
+        item.rid = sqlite3_column_int64(stmt.get(), 0);
+        item.name = (const char *)sqlite3_column_text(stmt.get(), 1);
+        item.length = sqlite3_column_int64(stmt.get(), 2);
+        if (sqlite3_column_type(stmt.get(), 3) == SQLITE_TEXT) {
+            item.assembly = (const char *)sqlite3_column_text(stmt.get(), 3);
+        }
+        if (sqlite3_column_type(stmt.get(), 4) == SQLITE_TEXT) {
+            item.refget_id = (const char *)sqlite3_column_text(stmt.get(), 4);
+        }
+        if (sqlite3_column_type(stmt.get(), 4) == SQLITE_TEXT) {
+            item.meta_json = (const char *)sqlite3_column_text(stmt.get(), 5);
+        }
+        ans[item.rid] = item;
+    }
+    if (rc != SQLITE_DONE) {
+        throw runtime_error("GenomicSQLite: error querying reference sequences");
+    }
+    return ans;
+}
+
+map<string, gri_refseq_t>
+GetGenomicReferenceSequencesByName(sqlite3 *dbconn, const string &assembly, const string &schema) {
+    map<string, gri_refseq_t> ans;
+    for (const auto &p : GetGenomicReferenceSequencesByRid(dbconn, assembly, schema)) {
+        const gri_refseq_t &item = p.second;
+        if (ans.find(item.name) != ans.end()) {
+            throw runtime_error("GenomicSQLite: reference sequence names are not unique");
+        }
+        ans[item.name] = item;
+    }
+    return ans;
+}
+
+// Per-connection cache of the main database's _gri_refseq name<->rid mapping, backing the
+// gri_rid() & gri_refseq_name() SQL functions so they needn't run a correlated subquery on
+// _gri_refseq per row. Invalidated by SQLITE_FCNTL_DATA_VERSION + sqlite3_total_changes(), the
+// same scheme GenomicRangeIndexLevelsCursor uses for its level bounds.
+struct RefseqCache {
+    uint32_t data_version = UINT32_MAX;
+    int db_total_changes = INT_MAX;
+    map<string, long long> rid_by_name;
+    map<long long, string> name_by_rid;
+    int refcount = 0; // # of function registrations holding this
+};
+
+static void refseq_cache_unref(void *p) {
+    RefseqCache *cache = reinterpret_cast<RefseqCache *>(p);
+    if (--cache->refcount <= 0) {
+        delete cache;
+    }
+}
+
+// ensure cache is fresh; on error, sets the SQL function result & returns false
+static bool refseq_cache_refresh(sqlite3_context *ctx, RefseqCache &cache) {
+    sqlite3 *db = sqlite3_context_db_handle(ctx);
+    uint32_t data_version = UINT32_MAX;
+    if (sqlite3_file_control(db, nullptr, SQLITE_FCNTL_DATA_VERSION, &data_version) != SQLITE_OK) {
+        sqlite3_result_error(ctx, "GenomicSQLite: error in SQLITE_FCNTL_DATA_VERSION", -1);
+        return false;
+    }
+    int db_total_changes = sqlite3_total_changes(db);
+    if (data_version == cache.data_version && db_total_changes == cache.db_total_changes) {
+        return true;
+    }
+    try {
+        auto by_rid = GetGenomicReferenceSequencesByRid(db, "", "");
+        cache.rid_by_name.clear();
+        cache.name_by_rid.clear();
+        for (const auto &p : by_rid) {
+            cache.name_by_rid[p.first] = p.second.name;
+            if (!cache.rid_by_name.insert(make_pair(p.second.name, p.first)).second) {
+                throw runtime_error("GenomicSQLite: reference sequence names are not unique");
+            }
+        }
+    } catch (std::bad_alloc &) {
+        sqlite3_result_error_nomem(ctx);
+        return false;
+    } catch (std::exception &exn) {
+        sqlite3_result_error(ctx, exn.what(), -1);
+        return false;
+    }
+    cache.data_version = data_version;
+    cache.db_total_changes = db_total_changes;
+    return true;
+}
+
+static void sqlfn_gri_rid(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
+    if (sqlite3_value_type(argv[0]) == SQLITE_NULL) {
+        return sqlite3_result_null(ctx);
+    }
+    string name;
+    ARG_TEXT(name, 0)
+    RefseqCache *cache = reinterpret_cast<RefseqCache *>(sqlite3_user_data(ctx));
+    if (!refseq_cache_refresh(ctx, *cache)) {
+        return;
+    }
+    auto found = cache->rid_by_name.find(name);
+    if (found == cache->rid_by_name.end()) {
+        return sqlite3_result_null(ctx); // unknown name, like an empty LEFT JOIN
+    }
+    sqlite3_result_int64(ctx, found->second);
+}
+
+static void sqlfn_gri_refseq_name(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
+    if (sqlite3_value_type(argv[0]) == SQLITE_NULL) {
+        return sqlite3_result_null(ctx);
+    }
+    sqlite3_int64 rid;
+    ARG(rid, 0, SQLITE_INTEGER, int64)
+    RefseqCache *cache = reinterpret_cast<RefseqCache *>(sqlite3_user_data(ctx));
+    if (!refseq_cache_refresh(ctx, *cache)) {
+        return;
+    }
+    auto found = cache->name_by_rid.find(rid);
+    if (found == cache->name_by_rid.end()) {
+        return sqlite3_result_null(ctx);
+    }
+    sqlite3_result_text(ctx, found->second.c_str(), found->second.size(), SQLITE_TRANSIENT);
+}
+
+/**************************************************************************************************
+ * SQL helper functions for compactly storing DNA/RNA sequences
+ **************************************************************************************************/
+
+/*
+crumbs = []
+for c in (chr(i) for i in range(256)):
+    if c in "TtUu":
+        crumbs.append(0)
+    elif c in "Cc":
+        crumbs.append(1)
+    elif c in "Aa":
+        crumbs.append(2)
+    elif c in "Gg":
+        crumbs.append(3)
+    else:
+        crumbs.append(0xFF)
+
+print(crumbs)
+*/
+const unsigned char dna_crumb_table[] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 2,    0xFF, 1,    0xFF, 0xFF, 0xFF, 3,    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0,    0,    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 2,    0xFF, 1,    0xFF, 0xFF, 0xFF, 3,    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0,    0,    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define GENOMICSQLITE_TWOBIT_SSSE3 1
+#include <immintrin.h>
+
+/*
+ * Encode complete 16-base chunks of seq with SSSE3, 16 bases -> 4 packed bytes per iteration:
+ * classify each character by its low nibble via pshufb ('A'/'a' -> 1, 'C'/'c' -> 3, 'T'/'t' -> 4,
+ * 'U'/'u' -> 5, 'G'/'g' -> 7), validating against the expected (lowercased) character, then pack
+ * crumbs 4-to-a-byte with two multiply-add steps. Returns the number of bases consumed (a
+ * multiple of 16), stopping short at any chunk containing a non-nucleotide byte so the caller's
+ * scalar loop can report it precisely.
+ */
+__attribute__((target("ssse3"))) static size_t
+nucleotides_twobit_ssse3(const char *seq, size_t len, unsigned char *out) {
+    const __m128i nib_mask = _mm_set1_epi8(0x0F), case_bit = _mm_set1_epi8(0x20);
+    const __m128i crumb_tab = _mm_setr_epi8(0, 2, 0, 1, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i expect_tab =
+        _mm_setr_epi8(0, 'a', 0, 'c', 't', 'u', 0, 'g', 0, 0, 0, 0, 0, 0, 0, 0);
+    // weights packing big-endian crumb order: first base lands in the byte's high two bits
+    const __m128i w_pair = _mm_set1_epi16(0x0104), w_quad = _mm_set1_epi32(0x00010010);
+    const char z = (char)0x80; // pshufb index clearing the output byte
+    const __m128i gather = _mm_setr_epi8(0, 4, 8, 12, z, z, z, z, z, z, z, z, z, z, z, z);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i chars = _mm_loadu_si128((const __m128i *)(seq + i));
+        __m128i nibs = _mm_and_si128(chars, nib_mask);
+        __m128i expect = _mm_shuffle_epi8(expect_tab, nibs);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_or_si128(chars, case_bit), expect)) != 0xFFFF) {
+            break; // chunk has a non-nucleotide (or non-ASCII) byte
+        }
+        __m128i crumbs = _mm_shuffle_epi8(crumb_tab, nibs);
+        __m128i pairs = _mm_maddubs_epi16(crumbs, w_pair);  // c0*4+c1 per byte pair
+        __m128i quads = _mm_madd_epi16(pairs, w_quad);      // (c0*4+c1)*16 + c2*4+c3
+        unsigned packed = (unsigned)_mm_cvtsi128_si32(_mm_shuffle_epi8(quads, gather));
+        memcpy(out + i / 4, &packed, 4);
+    }
+    return i;
+}
+#endif
+
+extern "C" int nucleotides_twobit(const char *seq, size_t len, void *out) {
+    if (len == 0) {
+        return 0;
+    }
+
+    unsigned char *outbyte = (unsigned char *)out;
+
+    // Header byte: the low two bits specify how many crumbs at the end of the buffer must be
+    // ignored by the decoder (0, 1, 2, or 3). Exception: if len == 1 then these low two bits
+    // encode the nucleotide directly.
+    auto trailing_crumbs = (4 - len % 4) % 4;
+    assert(trailing_crumbs >= 0 && trailing_crumbs <= 3);
+    if (len > 1) {
+        *(outbyte++) = trailing_crumbs;
+    }
+
+    size_t i = 0;
+#ifdef GENOMICSQLITE_TWOBIT_SSSE3
+    if (len >= 16) {
+        static const bool ssse3 = __builtin_cpu_supports("ssse3");
+        if (ssse3) {
+            i = nucleotides_twobit_ssse3(seq, len, outbyte);
+            assert(i % 16 == 0 && i <= len);
+            outbyte += i / 4;
+        }
+    }
+#endif
+    unsigned char byte = 0;
+    for (; i < len; ++i) {
+        const char c_i = seq[i];
+        if (c_i <= 0) {
+            return -2;
+        }
+        assert(c_i >= 0 && c_i < 128);
+        const unsigned char crumb = dna_crumb_table[(unsigned char)c_i];
+        if (crumb > 3) {
+            return -1;
+        }
+        assert((byte >> 6) == 0);
+        byte = (byte << 2) | crumb;
+        if (i % 4 == 3) {
+            *(outbyte++) = byte;
+            byte = 0;
+        }
+    }
+
+    if (trailing_crumbs) {
+        assert(len && (byte >> (2 * (4 - trailing_crumbs))) == 0);
+        if (len > 1) {
+            byte <<= (2 * trailing_crumbs);
+        }
+        *(outbyte++) = byte;
+    } else {
+        assert(byte == 0);
+    }
+
+    return (outbyte - (unsigned char *)out);
+}
+
+static void sqlfn_nucleotides_twobit(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
+    assert(argc == 1);
+    auto arg0ty = sqlite3_value_type(argv[0]);
+    if (arg0ty == SQLITE_NULL) {
+        return sqlite3_result_null(ctx);
+    } else if (arg0ty != SQLITE_TEXT) {
+        return sqlite3_result_error(ctx, "nucleotides_twobit() expected TEXT", -1);
+    }
+
+    auto seqlen = sqlite3_value_bytes(argv[0]);
+    assert(seqlen >= 0);
+    if (seqlen <= 0) {
+        return sqlite3_result_value(ctx, argv[0]);
+    }
+
+    auto seq = (const char *)sqlite3_value_text(argv[0]);
+    if (!seq) {
+        return sqlite3_result_error_nomem(ctx);
+    }
+
+    try {
+        std::unique_ptr<unsigned char[]> buf(new unsigned char[(seqlen + 7) / 4]);
+        int rc = nucleotides_twobit(seq, (size_t)seqlen, buf.get());
+        if (rc == -2) {
+            return sqlite3_result_error(ctx, "non-ASCII input to nucleotides_twobit()", -1);
+        } else if (rc < 0) {
+            return sqlite3_result_text(ctx, seq, seqlen, SQLITE_TRANSIENT);
+        }
+        return sqlite3_result_blob64(ctx, buf.get(), rc, SQLITE_TRANSIENT);
+    } catch (std::bad_alloc &) {
+        return sqlite3_result_error_nomem(ctx);
+    }
+}
+
+extern "C" size_t twobit_length(const void *data, size_t sz) {
+    if (sz < 2) {
+        return sz;
+    }
+    const unsigned char *bytes = (const unsigned char *)data;
+    unsigned char trailing_crumbs = bytes[0] & 0b11;
+    return 4 * (sz - 1) - trailing_crumbs;
+}
+
+static void sqlfn_twobit_length(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
+    assert(argc == 1);
+    try {
+        if (sqlite3_value_type(argv[0]) == SQLITE_BLOB) {
+            size_t sz = sqlite3_value_bytes(argv[0]);
+            size_t ans = twobit_length(sqlite3_value_blob(argv[0]), sz);
+            if (ans > 2147483647) { // https://www.sqlite.org/limits.html
+                sqlite3_result_error_toobig(ctx);
+            } else {
+                sqlite3_result_int64(ctx, ans);
+            }
+        } else if (sqlite3_value_type(argv[0]) == SQLITE_TEXT) {
+            sqlite3_result_int64(ctx, sqlite3_value_bytes(argv[0]));
+        } else if (sqlite3_value_type(argv[0]) == SQLITE_NULL) {
+            sqlite3_result_null(ctx);
+        } else {
+            sqlite3_result_error(ctx, "twobit_length() expected BLOB or TEXT", -1);
+        }
+    } catch (std::bad_alloc &) {
+        sqlite3_result_error_nomem(ctx);
+    }
+}
+
+/*
+letters = ('T', 'C', 'A', 'G')
+dna4mers = []
+for byte in range(256):
+    rev4mer = []
+    for _ in range(4):
+        rev4mer.append(letters[byte & 0b11])
+        byte = byte >> 2
+    dna4mers.append(''.join(reversed(rev4mer)))
+
+print(dna4mers)
+*/
+const char *twobit_dna4mers[] = {
+    "TTTT", "TTTC", "TTTA", "TTTG", "TTCT", "TTCC", "TTCA", "TTCG", "TTAT", "TTAC", "TTAA", "TTAG",
+    "TTGT", "TTGC", "TTGA", "TTGG", "TCTT", "TCTC", "TCTA", "TCTG", "TCCT", "TCCC", "TCCA", "TCCG",
+    "TCAT", "TCAC", "TCAA", "TCAG", "TCGT", "TCGC", "TCGA", "TCGG", "TATT", "TATC", "TATA", "TATG",
+    "TACT", "TACC", "TACA", "TACG", "TAAT", "TAAC", "TAAA", "TAAG", "TAGT", "TAGC", "TAGA", "TAGG",
+    "TGTT", "TGTC", "TGTA", "TGTG", "TGCT", "TGCC", "TGCA", "TGCG", "TGAT", "TGAC", "TGAA", "TGAG",
+    "TGGT", "TGGC", "TGGA", "TGGG", "CTTT", "CTTC", "CTTA", "CTTG", "CTCT", "CTCC", "CTCA", "CTCG",
+    "CTAT", "CTAC", "CTAA", "CTAG", "CTGT", "CTGC", "CTGA", "CTGG", "CCTT", "CCTC", "CCTA", "CCTG",
+    "CCCT", "CCCC", "CCCA", "CCCG", "CCAT", "CCAC", "CCAA", "CCAG", "CCGT", "CCGC", "CCGA", "CCGG",
+    "CATT", "CATC", "CATA", "CATG", "CACT", "CACC", "CACA", "CACG", "CAAT", "CAAC", "CAAA", "CAAG",
+    "CAGT", "CAGC", "CAGA", "CAGG", "CGTT", "CGTC", "CGTA", "CGTG", "CGCT", "CGCC", "CGCA", "CGCG",
+    "CGAT", "CGAC", "CGAA", "CGAG", "CGGT", "CGGC", "CGGA", "CGGG", "ATTT", "ATTC", "ATTA", "ATTG",
+    "ATCT", "ATCC", "ATCA", "ATCG", "ATAT", "ATAC", "ATAA", "ATAG", "ATGT", "ATGC", "ATGA", "ATGG",
+    "ACTT", "ACTC", "ACTA", "ACTG", "ACCT", "ACCC", "ACCA", "ACCG", "ACAT", "ACAC", "ACAA", "ACAG",
+    "ACGT", "ACGC", "ACGA", "ACGG", "AATT", "AATC", "AATA", "AATG", "AACT", "AACC", "AACA", "AACG",
+    "AAAT", "AAAC", "AAAA", "AAAG", "AAGT", "AAGC", "AAGA", "AAGG", "AGTT", "AGTC", "AGTA", "AGTG",
+    "AGCT", "AGCC", "AGCA", "AGCG", "AGAT", "AGAC", "AGAA", "AGAG", "AGGT", "AGGC", "AGGA", "AGGG",
+    "GTTT", "GTTC", "GTTA", "GTTG", "GTCT", "GTCC", "GTCA", "GTCG", "GTAT", "GTAC", "GTAA", "GTAG",
+    "GTGT", "GTGC", "GTGA", "GTGG", "GCTT", "GCTC", "GCTA", "GCTG", "GCCT", "GCCC", "GCCA", "GCCG",
+    "GCAT", "GCAC", "GCAA", "GCAG", "GCGT", "GCGC", "GCGA", "GCGG", "GATT", "GATC", "GATA", "GATG",
+    "GACT", "GACC", "GACA", "GACG", "GAAT", "GAAC", "GAAA", "GAAG", "GAGT", "GAGC", "GAGA", "GAGG",
+    "GGTT", "GGTC", "GGTA", "GGTG", "GGCT", "GGCC", "GGCA", "GGCG", "GGAT", "GGAC", "GGAA", "GGAG",
+    "GGGT", "GGGC", "GGGA", "GGGG"};
+const char *twobit_rna4mers[] = {
+    "UUUU", "UUUC", "UUUA", "UUUG", "UUCU", "UUCC", "UUCA", "UUCG", "UUAU", "UUAC", "UUAA", "UUAG",
+    "UUGU", "UUGC", "UUGA", "UUGG", "UCUU", "UCUC", "UCUA", "UCUG", "UCCU", "UCCC", "UCCA", "UCCG",
+    "UCAU", "UCAC", "UCAA", "UCAG", "UCGU", "UCGC", "UCGA", "UCGG", "UAUU", "UAUC", "UAUA", "UAUG",
+    "UACU", "UACC", "UACA", "UACG", "UAAU", "UAAC", "UAAA", "UAAG", "UAGU", "UAGC", "UAGA", "UAGG",
+    "UGUU", "UGUC", "UGUA", "UGUG", "UGCU", "UGCC", "UGCA", "UGCG", "UGAU", "UGAC", "UGAA", "UGAG",
+    "UGGU", "UGGC", "UGGA", "UGGG", "CUUU", "CUUC", "CUUA", "CUUG", "CUCU", "CUCC", "CUCA", "CUCG",
+    "CUAU", "CUAC", "CUAA", "CUAG", "CUGU", "CUGC", "CUGA", "CUGG", "CCUU", "CCUC", "CCUA", "CCUG",
+    "CCCU", "CCCC", "CCCA", "CCCG", "CCAU", "CCAC", "CCAA", "CCAG", "CCGU", "CCGC", "CCGA", "CCGG",
+    "CAUU", "CAUC", "CAUA", "CAUG", "CACU", "CACC", "CACA", "CACG", "CAAU", "CAAC", "CAAA", "CAAG",
+    "CAGU", "CAGC", "CAGA", "CAGG", "CGUU", "CGUC", "CGUA", "CGUG", "CGCU", "CGCC", "CGCA", "CGCG",
+    "CGAU", "CGAC", "CGAA", "CGAG", "CGGU", "CGGC", "CGGA", "CGGG", "AUUU", "AUUC", "AUUA", "AUUG",
+    "AUCU", "AUCC", "AUCA", "AUCG", "AUAU", "AUAC", "AUAA", "AUAG", "AUGU", "AUGC", "AUGA", "AUGG",
+    "ACUU", "ACUC", "ACUA", "ACUG", "ACCU", "ACCC", "ACCA", "ACCG", "ACAU", "ACAC", "ACAA", "ACAG",
+    "ACGU", "ACGC", "ACGA", "ACGG", "AAUU", "AAUC", "AAUA", "AAUG", "AACU", "AACC", "AACA", "AACG",
+    "AAAU", "AAAC", "AAAA", "AAAG", "AAGU", "AAGC", "AAGA", "AAGG", "AGUU", "AGUC", "AGUA", "AGUG",
+    "AGCU", "AGCC", "AGCA", "AGCG", "AGAU", "AGAC", "AGAA", "AGAG", "AGGU", "AGGC", "AGGA", "AGGG",
+    "GUUU", "GUUC", "GUUA", "GUUG", "GUCU", "GUCC", "GUCA", "GUCG", "GUAU", "GUAC", "GUAA", "GUAG",
+    "GUGU", "GUGC", "GUGA", "GUGG", "GCUU", "GCUC", "GCUA", "GCUG", "GCCU", "GCCC", "GCCA", "GCCG",
+    "GCAU", "GCAC", "GCAA", "GCAG", "GCGU", "GCGC", "GCGA", "GCGG", "GAUU", "GAUC", "GAUA", "GAUG",
+    "GACU", "GACC", "GACA", "GACG", "GAAU", "GAAC", "GAAA", "GAAG", "GAGU", "GAGC", "GAGA", "GAGG",
+    "GGUU", "GGUC", "GGUA", "GGUG", "GGCU", "GGCC", "GGCA", "GGCG", "GGAU", "GGAC", "GGAA", "GGAG",
+    "GGGU", "GGGC", "GGGA", "GGGG"};
+
+#ifdef GENOMICSQLITE_TWOBIT_SSSE3
+/*
+ * Decode complete 16-byte chunks of two-bit payload with SSSE3, 16 bytes -> 64 nucleotide
+ * characters per iteration: pshufb maps each byte's high & low nibble to the letters of its
+ * first/second crumb, then unpacks interleave the four per-byte letters into sequence order.
+ * Returns the number of payload bytes consumed (a multiple of 16); caller decodes the rest via
+ * the 4-mer table.
+ */
+__attribute__((target("ssse3"))) static size_t
+twobit_nucleotides_ssse3(const unsigned char *in, size_t nbytes, bool rna, char *out) {
+    const __m128i nib_mask = _mm_set1_epi8(0x0F);
+    const __m128i first_tab =
+        rna ? _mm_setr_epi8('U', 'U', 'U', 'U', 'C', 'C', 'C', 'C', 'A', 'A', 'A', 'A', 'G', 'G',
+                            'G', 'G')
+            : _mm_setr_epi8('T', 'T', 'T', 'T', 'C', 'C', 'C', 'C', 'A', 'A', 'A', 'A', 'G', 'G',
+                            'G', 'G');
+    const __m128i second_tab =
+        rna ? _mm_setr_epi8('U', 'C', 'A', 'G', 'U', 'C', 'A', 'G', 'U', 'C', 'A', 'G', 'U', 'C',
+                            'A', 'G')
+            : _mm_setr_epi8('T', 'C', 'A', 'G', 'T', 'C', 'A', 'G', 'T', 'C', 'A', 'G', 'T', 'C',
+                            'A', 'G');
+    size_t i = 0;
+    for (; i + 16 <= nbytes; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)(in + i));
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(bytes, 4), nib_mask);
+        __m128i lo = _mm_and_si128(bytes, nib_mask);
+        __m128i c0 = _mm_shuffle_epi8(first_tab, hi), c1 = _mm_shuffle_epi8(second_tab, hi);
+        __m128i c2 = _mm_shuffle_epi8(first_tab, lo), c3 = _mm_shuffle_epi8(second_tab, lo);
+        __m128i p01lo = _mm_unpacklo_epi8(c0, c1), p01hi = _mm_unpackhi_epi8(c0, c1);
+        __m128i p23lo = _mm_unpacklo_epi8(c2, c3), p23hi = _mm_unpackhi_epi8(c2, c3);
+        char *o = out + 4 * i;
+        _mm_storeu_si128((__m128i *)o, _mm_unpacklo_epi16(p01lo, p23lo));
+        _mm_storeu_si128((__m128i *)(o + 16), _mm_unpackhi_epi16(p01lo, p23lo));
+        _mm_storeu_si128((__m128i *)(o + 32), _mm_unpacklo_epi16(p01hi, p23hi));
+        _mm_storeu_si128((__m128i *)(o + 48), _mm_unpackhi_epi16(p01hi, p23hi));
+    }
+    return i;
+}
+#endif
+
+static void twobit_nucleotides(const void *data, size_t sz, size_t ofs, size_t len, bool rna,
+                               char *out) {
+    const char **table = rna ? twobit_rna4mers : twobit_dna4mers;
+    // special cases for length-0 and 1 blobs
+    if (sz < 2) {
+        if (len == 0) {
+            out[0] = 0;
+            return;
+        }
+        assert(ofs == 0 && len == 1 && sz == 1);
+        out[0] = table[*(const unsigned char *)data & 0b11][3];
+        out[1] = 0;
+        return;
+    }
+    const unsigned char *pbyte = ((const unsigned char *)data) + 1 + ofs / 4;
+    size_t out_cursor = 0;
+    // decode first payload byte (maybe only part of it) crumb-by-crumb
+    for (auto crumb = ofs % 4; crumb < 4 && out_cursor < len;) {
+        out[out_cursor++] = table[*pbyte][crumb++];
+    }
+    ++pbyte;
+#ifdef GENOMICSQLITE_TWOBIT_SSSE3
+    // decode internal bytes 16 at a time (64 characters per iteration)
+    if (out_cursor + 64 <= len) {
+        static const bool ssse3 = __builtin_cpu_supports("ssse3");
+        if (ssse3) {
+            size_t consumed =
+                twobit_nucleotides_ssse3(pbyte, (len - out_cursor) / 4, rna, out + out_cursor);
+            assert(consumed % 16 == 0);
+            pbyte += consumed;
+            out_cursor += 4 * consumed;
+        }
+    }
+#endif
+    // decode remaining internal bytes to 4-mers
+    for (; out_cursor + 4 <= len; out_cursor += 4) {
+        memcpy(out + out_cursor, table[*(pbyte++)], 4);
+    }
+    // decode last payload byte crumb-by-crumb, if needed
+    for (size_t crumb = 0; out_cursor < len;) {
+        assert(crumb < 4);
+        out[out_cursor++] = table[*pbyte][crumb++];
+    }
+    assert(out_cursor == len);
+    assert(pbyte - (const unsigned char *)data <= sz);
+    out[out_cursor] = 0;
+}
+
+extern "C" void twobit_dna(const void *data, size_t sz, size_t ofs, size_t len, char *out) {
+    return twobit_nucleotides(data, sz, ofs, len, false, out);
+}
+
+extern "C" void twobit_rna(const void *data, size_t sz, size_t ofs, size_t len, char *out) {
+    return twobit_nucleotides(data, sz, ofs, len, true, out);
+}
+
+static void twobit_nucleotides(sqlite3_context *ctx, int argc, sqlite3_value **argv, bool rna) {
+    assert(argc >= 1 && argc <= 3);
+    bool blob = false;
+    switch (sqlite3_value_type(argv[0])) {
+    case SQLITE_TEXT:
+        break;
+    case SQLITE_BLOB:
+        blob = true;
+        break;
+    case SQLITE_NULL:
+        return sqlite3_result_null(ctx);
+    default:
+        return sqlite3_result_error(ctx, "twobit_dna() expected BLOB or TEXT", -1);
+    }
+
+    // Y and Z are as https://sqlite.org/lang_corefunc.html#substr
+    ssize_t Y = 0, Zval = -1;
+    ARG_OPTIONAL(Y, 1, SQLITE_INTEGER, int);
+    ARG_OPTIONAL(Zval, 2, SQLITE_INTEGER, int);
+    ssize_t *Z = (argc >= 3 && sqlite3_value_type(argv[2]) != SQLITE_NULL) ? &Zval : nullptr;
+
+    try {
+        size_t sz = (size_t)sqlite3_value_bytes(argv[0]);
+        size_t len = blob ? twobit_length(sqlite3_value_blob(argv[0]), sz) : sz;
+
+        // based on Y and Z, explicate the zero-based offset & length of the desired substring.
+        // see this convoluted logic:
+        //   https://github.com/sqlite/sqlite/blob/d924e7bc78a4ca604bce0f8d9d0390d3feddba01/src/func.c#L299
+        size_t sub_ofs = 0;
+        if (Y > 0) {
+            sub_ofs = Y - 1;
+        } else if (Y < 0) {
+            sub_ofs = (size_t)max(0L, Y + (ssize_t)len);
+        }
+        if (sub_ofs > len) {
+            return sqlite3_result_text(ctx, "", 0, SQLITE_STATIC);
+        }
+        size_t sub_len = len - sub_ofs;
+        if (Z) {
+            if (*Z < 0) {
+                sub_len = (size_t)(0 - *Z);
+                sub_len = min(sub_ofs, sub_len);
+                sub_ofs -= sub_len;
+            } else {
+                sub_len = (size_t)*Z;
+                if (Y == 0) {
+                    sub_len -= min(1UL, sub_len);
+                } else if (0 - Y > (ssize_t)len) {
+                    sub_len -= min(sub_len, 0 - Y - len);
+                }
+                sub_len = min(sub_len, len - sub_ofs);
+            }
+        }
+        if (sub_len == 0) {
+            return sqlite3_result_text(ctx, "", 0, SQLITE_STATIC);
+        }
+        assert(sub_ofs + sub_len <= (blob ? len : sz));
+
+        if (blob) {
+            // decode two-bit-encoded BLOB directly into a buffer whose ownership passes to
+            // SQLite, sparing the redundant copy SQLITE_TRANSIENT would make of multi-megabyte
+            // results
+            char *buf = (char *)sqlite3_malloc64(sub_len + 1);
+            if (!buf) {
+                return sqlite3_result_error_nomem(ctx);
+            }
+            twobit_nucleotides(sqlite3_value_blob(argv[0]), sz, sub_ofs, sub_len, rna, buf);
+            sqlite3_result_text64(ctx, buf, sub_len, sqlite3_free, SQLITE_UTF8);
+        } else if (sub_ofs == 0 && sub_len == len) {
+            // pass through complete text
+            sqlite3_result_value(ctx, argv[0]);
+        } else {
+            // substr of text
+            sqlite3_result_text(ctx, ((const char *)sqlite3_value_text(argv[0])) + sub_ofs, sub_len,
+                                SQLITE_TRANSIENT);
+        }
+    } catch (std::bad_alloc &) {
+        sqlite3_result_error_nomem(ctx);
+    } catch (SQLite::Exception &exn) {
+        if (exn.getErrorCode() == SQLITE_TOOBIG) {
+            sqlite3_result_error_toobig(ctx);
+        } else {
+            sqlite3_result_error(ctx, exn.getErrorStr(), -1);
+        }
+    } catch (std::exception &exn) {
+        sqlite3_result_error(ctx, exn.what(), -1);
+    }
+}
+
+static void sqlfn_twobit_dna(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
+    twobit_nucleotides(ctx, argc, argv, false);
+}
+
+static void sqlfn_twobit_rna(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
+    twobit_nucleotides(ctx, argc, argv, true);
+}
+
+/*
+ * Incremental window fetch: decode the nucleotide subsequence [ofs, ofs+len) of a two-bit blob
+ * stored in table.column at the given rowid, reading only the header byte and the payload bytes
+ * covering the window via sqlite3_blob_open incremental I/O — twobit_dna(column, ...) in SQL makes
+ * SQLite materialize the complete blob before the function can slice it, which for a packed
+ * chromosome means decompressing hundreds of megabytes to serve a 100bp window.
+ */
+string GenomicSQLiteTwoBitFetch(sqlite3 *dbconn, const string &schema_table, const string &column,
+                                sqlite3_int64 rowid, sqlite3_int64 ofs, sqlite3_int64 len,
+                                bool rna) {
+    auto split = split_schema_table(schema_table);
+    string schema =
+        split.first.empty() ? "main" : split.first.substr(0, split.first.size() - 1);
+    sqlite3_blob *pBlob = nullptr;
+    int rc =
+        sqlite3_blob_open(dbconn, schema.c_str(), split.second.c_str(), column.c_str(), rowid, 0,
+                          &pBlob);
+    if (rc != SQLITE_OK) {
+        throw SQLite::Exception("genomicsqlite_twobit_fetch(): " + string(sqlite3_errmsg(dbconn)),
+                                rc);
+    }
+    unique_ptr<sqlite3_blob, int (*)(sqlite3_blob *)> blob(pBlob, sqlite3_blob_close);
+
+    sqlite3_int64 sz = sqlite3_blob_bytes(pBlob);
+    unsigned char header = 0;
+    if (sz >= 1 && (rc = sqlite3_blob_read(pBlob, &header, 1, 0)) != SQLITE_OK) {
+        throw SQLite::Exception("genomicsqlite_twobit_fetch(): " + string(sqlite3_errmsg(dbconn)),
+                                rc);
+    }
+    sqlite3_int64 seqlen = sz < 2 ? sz : 4 * (sz - 1) - (header & 0b11);
+    if (ofs < 0 || len < 0 || ofs > seqlen || len > seqlen - ofs) {
+        throw std::invalid_argument("genomicsqlite_twobit_fetch(): window out of range");
+    }
+    if (len == 0) {
+        return string();
+    }
+    if (sz < 2) {
+        // length-1 blob: the header byte is the whole sequence
+        char out[2];
+        twobit_nucleotides(&header, (size_t)sz, (size_t)ofs, (size_t)len, rna, out);
+        return string(out, (size_t)len);
+    }
+
+    // read just the payload bytes covering [ofs, ofs+len) and decode them as a miniature blob
+    // whose payload starts at crumb ofs%4
+    sqlite3_int64 first_byte = ofs / 4, last_byte = (ofs + len - 1) / 4;
+    vector<unsigned char> buf(1 + (size_t)(last_byte - first_byte + 1));
+    buf[0] = header;
+    rc = sqlite3_blob_read(pBlob, buf.data() + 1, (int)(buf.size() - 1), (int)(1 + first_byte));
+    if (rc != SQLITE_OK) {
+        throw SQLite::Exception("genomicsqlite_twobit_fetch(): " + string(sqlite3_errmsg(dbconn)),
+                                rc);
+    }
+    unique_ptr<char[]> out(new char[(size_t)len + 1]);
+    twobit_nucleotides(buf.data(), buf.size(), (size_t)(ofs % 4), (size_t)len, rna, out.get());
+    return string(out.get(), (size_t)len);
+}
+
+extern "C" int genomicsqlite_twobit_fetch(sqlite3 *dbconn, const char *table, const char *column,
+                                          sqlite3_int64 rowid, sqlite3_int64 ofs,
+                                          sqlite3_int64 len, char *out, char **pzErrMsg) {
+    assert(dbconn);
+    assert(table && table[0]);
+    assert(column && column[0]);
+    assert(out);
+    try {
+        string ans = GenomicSQLiteTwoBitFetch(dbconn, string(table), string(column), rowid, ofs,
+                                              len, false);
+        memcpy(out, ans.c_str(), ans.size() + 1);
+        return SQLITE_OK;
+    } catch (SQLite::Exception &exn) {
+        if (pzErrMsg) {
+            *pzErrMsg = sqlite3_mprintf("%s", exn.what());
+        }
+        return exn.getErrorCode();
+    } catch (std::exception &exn) {
+        if (pzErrMsg) {
+            *pzErrMsg = sqlite3_mprintf("%s", exn.what());
+        }
+        return SQLITE_ERROR;
+    }
+}
+
+/*
+revcomp_bytes = []
+for byte in range(256):
+    crumbs = [(byte >> sh) & 3 for sh in (6, 4, 2, 0)]
+    out = 0
+    for crumb in crumbs:  # reversed order, complemented (T<->A and C<->G is crumb XOR 2)
+        out = (out >> 2) | ((crumb ^ 2) << 6)
+    revcomp_bytes.append(out)
+
+print(revcomp_bytes)
+*/
+const unsigned char twobit_revcomp_bytes[] = {
+    0xAA, 0xEA, 0x2A, 0x6A, 0xBA, 0xFA, 0x3A, 0x7A, 0x8A, 0xCA, 0x0A, 0x4A,
+    0x9A, 0xDA, 0x1A, 0x5A, 0xAE, 0xEE, 0x2E, 0x6E, 0xBE, 0xFE, 0x3E, 0x7E,
+    0x8E, 0xCE, 0x0E, 0x4E, 0x9E, 0xDE, 0x1E, 0x5E, 0xA2, 0xE2, 0x22, 0x62,
+    0xB2, 0xF2, 0x32, 0x72, 0x82, 0xC2, 0x02, 0x42, 0x92, 0xD2, 0x12, 0x52,
+    0xA6, 0xE6, 0x26, 0x66, 0xB6, 0xF6, 0x36, 0x76, 0x86, 0xC6, 0x06, 0x46,
+    0x96, 0xD6, 0x16, 0x56, 0xAB, 0xEB, 0x2B, 0x6B, 0xBB, 0xFB, 0x3B, 0x7B,
+    0x8B, 0xCB, 0x0B, 0x4B, 0x9B, 0xDB, 0x1B, 0x5B, 0xAF, 0xEF, 0x2F, 0x6F,
+    0xBF, 0xFF, 0x3F, 0x7F, 0x8F, 0xCF, 0x0F, 0x4F, 0x9F, 0xDF, 0x1F, 0x5F,
+    0xA3, 0xE3, 0x23, 0x63, 0xB3, 0xF3, 0x33, 0x73, 0x83, 0xC3, 0x03, 0x43,
+    0x93, 0xD3, 0x13, 0x53, 0xA7, 0xE7, 0x27, 0x67, 0xB7, 0xF7, 0x37, 0x77,
+    0x87, 0xC7, 0x07, 0x47, 0x97, 0xD7, 0x17, 0x57, 0xA8, 0xE8, 0x28, 0x68,
+    0xB8, 0xF8, 0x38, 0x78, 0x88, 0xC8, 0x08, 0x48, 0x98, 0xD8, 0x18, 0x58,
+    0xAC, 0xEC, 0x2C, 0x6C, 0xBC, 0xFC, 0x3C, 0x7C, 0x8C, 0xCC, 0x0C, 0x4C,
+    0x9C, 0xDC, 0x1C, 0x5C, 0xA0, 0xE0, 0x20, 0x60, 0xB0, 0xF0, 0x30, 0x70,
+    0x80, 0xC0, 0x00, 0x40, 0x90, 0xD0, 0x10, 0x50, 0xA4, 0xE4, 0x24, 0x64,
+    0xB4, 0xF4, 0x34, 0x74, 0x84, 0xC4, 0x04, 0x44, 0x94, 0xD4, 0x14, 0x54,
+    0xA9, 0xE9, 0x29, 0x69, 0xB9, 0xF9, 0x39, 0x79, 0x89, 0xC9, 0x09, 0x49,
+    0x99, 0xD9, 0x19, 0x59, 0xAD, 0xED, 0x2D, 0x6D, 0xBD, 0xFD, 0x3D, 0x7D,
+    0x8D, 0xCD, 0x0D, 0x4D, 0x9D, 0xDD, 0x1D, 0x5D, 0xA1, 0xE1, 0x21, 0x61,
+    0xB1, 0xF1, 0x31, 0x71, 0x81, 0xC1, 0x01, 0x41, 0x91, 0xD1, 0x11, 0x51,
+    0xA5, 0xE5, 0x25, 0x65, 0xB5, 0xF5, 0x35, 0x75, 0x85, 0xC5, 0x05, 0x45,
+    0x95, 0xD5, 0x15, 0x55};
+
+/*
+ * Reverse-complement a two-bit-encoded blob directly in its packed representation, producing
+ * byte-identical output to re-encoding dna_revcomp() of the decoded sequence, without ever
+ * materializing the 4x larger text. Per payload byte, twobit_revcomp_bytes reverses the crumb
+ * order & complements; bytes are consumed back-to-front, and when the sequence length isn't a
+ * multiple of 4 the crumb stream is realigned by a two-bit shift carried across bytes.
+ */
+extern "C" void twobit_revcomp(const void *data, size_t sz, void *out) {
+    const unsigned char *in = (const unsigned char *)data;
+    unsigned char *outbyte = (unsigned char *)out;
+    if (sz == 0) {
+        return;
+    }
+    if (sz == 1) { // single nucleotide encoded directly in the low two bits
+        *outbyte = *in ^ 0b10;
+        return;
+    }
+    unsigned trailing_crumbs = in[0] & 0b11;
+    outbyte[0] = in[0]; // header: the reversed sequence has the same length
+    size_t n = sz - 1;  // payload bytes
+    if (!trailing_crumbs) {
+        for (size_t i = 0; i < n; ++i) {
+            outbyte[1 + i] = twobit_revcomp_bytes[in[sz - 1 - i]];
+        }
+        return;
+    }
+    // Reversed-complemented byte stream R[i] = revcomp(in[sz-1-i]) has the encoder's
+    // trailing_crumbs zero padding at its front; shift the whole crumb stream left to drop it.
+    const unsigned shift = 2 * trailing_crumbs;
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char r_i = twobit_revcomp_bytes[in[sz - 1 - i]],
+                      r_next = i + 1 < n ? twobit_revcomp_bytes[in[sz - 2 - i]] : 0;
+        outbyte[1 + i] = (unsigned char)((r_i << shift) | (r_next >> (8 - shift)));
+    }
+    outbyte[n] &= 0xFF << shift; // zero the trailing crumbs, as the encoder does
+}
+
+static void sqlfn_twobit_revcomp(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
+    assert(argc == 1);
+    switch (sqlite3_value_type(argv[0])) {
+    case SQLITE_NULL:
+        return sqlite3_result_null(ctx);
+    case SQLITE_BLOB: {
+        size_t sz = (size_t)sqlite3_value_bytes(argv[0]);
+        const void *data = sqlite3_value_blob(argv[0]);
+        if (sz && !data) {
+            return sqlite3_result_error_nomem(ctx);
+        }
+        unsigned char *buf = (unsigned char *)sqlite3_malloc64(sz ? sz : 1);
+        if (!buf) {
+            return sqlite3_result_error_nomem(ctx);
+        }
+        twobit_revcomp(data, sz, buf);
+        return sqlite3_result_blob64(ctx, buf, sz, sqlite3_free);
+    }
+    case SQLITE_TEXT: {
+        // text passes through dna_revcomp() so mixed BLOB/TEXT columns behave consistently
+        auto seqlen = sqlite3_value_bytes(argv[0]);
+        const char *seq = (const char *)sqlite3_value_text(argv[0]);
+        if (!seq) {
+            return sqlite3_result_error_nomem(ctx);
+        }
+        try {
+            std::unique_ptr<char[]> buf(new char[seqlen + 1]);
+            if (dna_revcomp(seq, seqlen, buf.get()) < 0) {
+                return sqlite3_result_error(ctx, "non-DNA input to twobit_revcomp()", -1);
+            }
+            return sqlite3_result_text(ctx, buf.get(), seqlen, SQLITE_TRANSIENT);
+        } catch (std::bad_alloc &) {
+            return sqlite3_result_error_nomem(ctx);
+        }
+    }
+    default:
+        return sqlite3_result_error(ctx, "twobit_revcomp() expected BLOB or TEXT", -1);
+    }
+}
+
+/*
+complement = [0xFF for i in range(256)]
+for l,r in (
+    ('A','T'), ('C','G'), ('G','C'), ('T','A'),
+    ('a','t'), ('c','g'), ('g','c'), ('t','a'),
+):
+    complement[ord(l)] = r
+
+print(complement)
+*/
+const unsigned char dna_complement_table[] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 'T',  0xFF, 'G',  0xFF, 0xFF, 0xFF, 'C',  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 'A',  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 't',  0xFF, 'g',  0xFF, 0xFF, 0xFF, 'c',  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 'a',  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+extern "C" int dna_revcomp(const char *dna, size_t len, char *out) {
+    for (; len; --len, ++out) {
+        unsigned char c = dna_complement_table[(unsigned char)dna[len - 1]];
+        if (c == 0xFF)
+            return -1;
+        *out = c;
+    }
+    *out = 0;
+    return 0;
+}
+
+static void sqlfn_dna_revcomp(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
+    assert(argc == 1);
+    const char *seq = nullptr;
+    ARG_TEXT_OPTIONAL(seq, 0);
+    if (!seq) {
+        return sqlite3_value_type(argv[0]) == SQLITE_NULL ? sqlite3_result_null(ctx)
+                                                          : sqlite3_result_error_nomem(ctx);
+    }
+
+    auto seqlen = sqlite3_value_bytes(argv[0]);
+    assert(seqlen >= 0);
+    if (seqlen <= 0) {
+        return sqlite3_result_value(ctx, argv[0]);
     }
-    ostringstream out;
-    for (size_t i = 0; i < nr_hardcoded_refseqs; ++i) {
-        if (i) {
-            out << ";\n";
+
+    try {
+        std::unique_ptr<char[]> buf(new char[seqlen + 1]);
+        if (dna_revcomp(seq, seqlen, buf.get()) < 0) {
+            return sqlite3_result_error(ctx, "non-DNA input to dna_revcomp()", -1);
         }
-        const hardcoded_refseq_t &hcrs = hardcoded_refseqs[i];
-        out << PutGenomicReferenceSequenceSQL(string(hcrs.name), hcrs.length, assembly,
-                                              hcrs.refget_id ? string(hcrs.refget_id) : string(),
-                                              string("{}"), -1, schema, i == 0);
+        return sqlite3_result_text(ctx, buf.get(), seqlen, SQLITE_TRANSIENT);
+    } catch (std::bad_alloc &) {
+        return sqlite3_result_error_nomem(ctx);
     }
-    return out.str();
 }
 
-extern "C" char *put_genomic_reference_assembly_sql(const char *assembly, const char *schema) {
-    C_WRAPPER(PutGenomicReferenceAssemblySQL(string(assembly), schema ? schema : ""));
-}
+/**************************************************************************************************
+ * uint_key(): memcmp-orderable sort key matching the UINT collating sequence
+ **************************************************************************************************/
 
-static void sqlfn_put_genomic_reference_assembly_sql(sqlite3_context *ctx, int argc,
-                                                     sqlite3_value **argv) {
-    string assembly, schema;
-    assert(argc == 1 || argc == 2);
-    ARG_TEXT(assembly, 0)
-    ARG_TEXT_OPTIONAL(schema, 1)
-    SQL_WRAPPER(PutGenomicReferenceAssemblySQL(assembly, schema))
+/*
+ * Encode text into a BLOB whose default BINARY comparison (a plain memcmp) orders exactly like
+ * the bundled UINT collation orders the original strings -- so a hot index can be built on the
+ * precomputed key instead of paying UINT's per-comparison digit-run parsing in every b-tree
+ * comparison. Non-digit bytes pass through verbatim; each maximal digit run is replaced by a
+ * marker byte, its leading-zero-stripped length (big-endian), then its significant digits:
+ *
+ *   - UINT compares any digit run to a non-digit byte via the run's first byte, and no non-digit
+ *     byte falls in ['0','9'], so a fixed marker byte in that range ('1') orders correctly
+ *     against all verbatim bytes.
+ *   - Between two runs, UINT order is stripped length, then digit memcmp -- exactly the encoded
+ *     byte order.
+ *   - UINT-equal strings ("x00123y" vs "x123y") get byte-identical keys.
+ */
+static void sqlfn_uint_key(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
+    assert(argc == 1);
+    if (sqlite3_value_type(argv[0]) == SQLITE_NULL) {
+        return sqlite3_result_null(ctx);
+    }
+    ARG_TYPE(0, SQLITE_TEXT)
+    const unsigned char *txt = sqlite3_value_text(argv[0]);
+    if (!txt) {
+        return sqlite3_result_error_nomem(ctx);
+    }
+    size_t len = (size_t)sqlite3_value_bytes(argv[0]);
+    try {
+        string key;
+        key.reserve(len + 8);
+        for (size_t i = 0; i < len;) {
+            if (!isdigit(txt[i])) {
+                key += (char)txt[i++];
+                continue;
+            }
+            while (i < len && txt[i] == '0') {
+                ++i;
+            }
+            size_t n = 0;
+            while (i + n < len && isdigit(txt[i + n])) {
+                ++n;
+            }
+            key += '1';
+            for (int shift = 24; shift >= 0; shift -= 8) {
+                key += (char)((n >> shift) & 0xFF);
+            }
+            key.append((const char *)txt + i, n);
+            i += n;
+        }
+        sqlite3_result_blob64(ctx, key.data(), key.size(), SQLITE_TRANSIENT);
+    } catch (std::bad_alloc &) {
+        sqlite3_result_error_nomem(ctx);
+    }
 }
 
-map<long long, gri_refseq_t>
-GetGenomicReferenceSequencesByRid(sqlite3 *dbconn, const string &assembly, const string &schema) {
-    map<long long, gri_refseq_t> ans;
-    string schema_prefix = schema.empty() ? "" : (schema + ".");
+/**************************************************************************************************
+ * binary JSON encoding for tag/metadata columns
+ **************************************************************************************************/
 
-    string query =
-        "SELECT _gri_rid, gri_refseq_name, gri_refseq_length, gri_assembly, gri_refget_id, gri_refseq_meta_json FROM " +
-        schema_prefix + "_gri_refseq";
-    if (!assembly.empty()) {
-        query += " WHERE gri_assembly = ?";
+/*
+ * JSON1 re-tokenizes text on every json_extract(), which dominates queries filtering on one tag
+ * across very large reads/variants tables. binary_json(j) parses the text once into a BLOB with
+ * a skippable tree layout; binary_json_extract(b, path) then probes a field with no parsing
+ * beyond varint hops, and binary_json_text(b) round-trips back to JSON text.
+ *
+ * Layout: magic byte 0xF5 (never valid UTF-8, so text & binary JSON can share a column), then an
+ * interned key table (varint count, then per key: varint length + bytes), then the node tree:
+ *
+ *   0x00 null | 0x01 false | 0x02 true
+ *   0x03 integer: zigzag varint
+ *   0x04 real: IEEE754 double, 8 bytes little-endian
+ *   0x05 string: varint length + UTF-8 bytes
+ *   0x06 object: varint payload length, varint count, count * (varint key index + node)
+ *   0x07 array:  varint payload length, varint count, count * node
+ *
+ * The payload length lets extraction skip an unwanted subtree in one hop, and object keys are
+ * matched by integer index instead of string comparison.
+ */
+namespace binary_json {
+
+const unsigned char MAGIC = 0xF5;
+enum NodeType {
+    T_NULL = 0,
+    T_FALSE = 1,
+    T_TRUE = 2,
+    T_INT = 3,
+    T_REAL = 4,
+    T_STR = 5,
+    T_OBJ = 6,
+    T_ARR = 7
+};
+const int MAX_DEPTH = 256;
+
+struct Value {
+    NodeType type = T_NULL;
+    long long i = 0;
+    double d = 0;
+    string s;
+    vector<pair<string, Value>> object;
+    vector<Value> array;
+};
+
+class TextParser {
+    const char *p_, *end_;
+
+    void skip_ws() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r')) {
+            ++p_;
+        }
     }
-    shared_ptr<sqlite3_stmt> stmt;
-    {
-        sqlite3_stmt *pStmt = nullptr;
-        if (sqlite3_prepare_v3(dbconn, query.c_str(), -1, 0, &pStmt, nullptr) != SQLITE_OK) {
-            throw runtime_error("GenomicSQLite: error querying reference sequences");
+
+    [[noreturn]] void malformed() { throw std::runtime_error("malformed JSON"); }
+
+    void expect(char c) {
+        if (p_ >= end_ || *p_ != c) {
+            malformed();
         }
-        stmt = shared_ptr<sqlite3_stmt>(pStmt, sqlite3_finalize);
+        ++p_;
     }
-    if (!assembly.empty()) {
-        if (sqlite3_bind_text(stmt.get(), 1, assembly.c_str(), -1, nullptr) != SQLITE_OK) {
-            throw runtime_error("GenomicSQLite: error querying reference sequences");
+
+    static void put_utf8(string &out, unsigned long cp) {
+        if (cp < 0x80) {
+            out += (char)cp;
+        } else if (cp < 0x800) {
+            out += (char)(0xC0 | (cp >> 6));
+            out += (char)(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += (char)(0xE0 | (cp >> 12));
+            out += (char)(0x80 | ((cp >> 6) & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        } else {
+            out += (char)(0xF0 | (cp >> 18));
+            out += (char)(0x80 | ((cp >> 12) & 0x3F));
+            out += (char)(0x80 | ((cp >> 6) & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
         }
     }
-    int rc;
-    while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
-        gri_refseq_t item;
-        item.rid = sqlite3_column_int64(stmt.get(), 0);
-        item.name = (const char *)sqlite3_column_text(stmt.get(), 1);
-        item.length = sqlite3_column_int64(stmt.get(), 2);
-        if (sqlite3_column_type(stmt.get(), 3) == SQLITE_TEXT) {
-            item.assembly = (const char *)sqlite3_column_text(stmt.get(), 3);
+
+    unsigned long parse_hex4() {
+        if (end_ - p_ < 4) {
+            malformed();
         }
-        if (sqlite3_column_type(stmt.get(), 4) == SQLITE_TEXT) {
-            item.refget_id = (const char *)sqlite3_column_text(stmt.get(), 4);
+        unsigned long v = 0;
+        for (int k = 0; k < 4; ++k) {
+            char c = *p_++;
+            v <<= 4;
+            if (c >= '0' && c <= '9') {
+                v |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                v |= c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                v |= c - 'A' + 10;
+            } else {
+                malformed();
+            }
         }
-        if (sqlite3_column_type(stmt.get(), 4) == SQLITE_TEXT) {
-            item.meta_json = (const char *)sqlite3_column_text(stmt.get(), 5);
+        return v;
+    }
+
+    string parse_string() {
+        expect('"');
+        string out;
+        while (true) {
+            if (p_ >= end_) {
+                malformed();
+            }
+            unsigned char c = *p_++;
+            if (c == '"') {
+                return out;
+            }
+            if (c != '\\') {
+                out += (char)c;
+                continue;
+            }
+            if (p_ >= end_) {
+                malformed();
+            }
+            switch (*p_++) {
+            case '"':
+                out += '"';
+                break;
+            case '\\':
+                out += '\\';
+                break;
+            case '/':
+                out += '/';
+                break;
+            case 'b':
+                out += '\b';
+                break;
+            case 'f':
+                out += '\f';
+                break;
+            case 'n':
+                out += '\n';
+                break;
+            case 'r':
+                out += '\r';
+                break;
+            case 't':
+                out += '\t';
+                break;
+            case 'u': {
+                unsigned long cp = parse_hex4();
+                if (cp >= 0xD800 && cp <= 0xDBFF) { // high surrogate: pair with the next escape
+                    if (end_ - p_ < 6 || p_[0] != '\\' || p_[1] != 'u') {
+                        malformed();
+                    }
+                    p_ += 2;
+                    unsigned long lo = parse_hex4();
+                    if (lo < 0xDC00 || lo > 0xDFFF) {
+                        malformed();
+                    }
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                }
+                put_utf8(out, cp);
+                break;
+            }
+            default:
+                malformed();
+            }
         }
-        ans[item.rid] = item;
     }
-    if (rc != SQLITE_DONE) {
-        throw runtime_error("GenomicSQLite: error querying reference sequences");
+
+    void parse_number(Value &v) {
+        const char *start = p_;
+        bool integral = true;
+        if (p_ < end_ && *p_ == '-') {
+            ++p_;
+        }
+        while (p_ < end_ && isdigit((unsigned char)*p_)) {
+            ++p_;
+        }
+        if (p_ == start || (p_ == start + 1 && *start == '-')) {
+            malformed();
+        }
+        if (p_ < end_ && *p_ == '.') {
+            integral = false;
+            ++p_;
+            while (p_ < end_ && isdigit((unsigned char)*p_)) {
+                ++p_;
+            }
+        }
+        if (p_ < end_ && (*p_ == 'e' || *p_ == 'E')) {
+            integral = false;
+            ++p_;
+            if (p_ < end_ && (*p_ == '+' || *p_ == '-')) {
+                ++p_;
+            }
+            while (p_ < end_ && isdigit((unsigned char)*p_)) {
+                ++p_;
+            }
+        }
+        string token(start, p_ - start);
+        if (integral) {
+            errno = 0;
+            long long i = strtoll(token.c_str(), nullptr, 10);
+            if (errno != ERANGE) {
+                v.type = T_INT;
+                v.i = i;
+                return;
+            }
+        }
+        v.type = T_REAL;
+        v.d = strtod(token.c_str(), nullptr);
     }
-    return ans;
+
+    void parse_value(Value &v, int depth) {
+        if (depth > MAX_DEPTH) {
+            malformed();
+        }
+        skip_ws();
+        if (p_ >= end_) {
+            malformed();
+        }
+        switch (*p_) {
+        case '{': {
+            ++p_;
+            v.type = T_OBJ;
+            skip_ws();
+            if (p_ < end_ && *p_ == '}') {
+                ++p_;
+                return;
+            }
+            while (true) {
+                skip_ws();
+                string key = parse_string();
+                skip_ws();
+                expect(':');
+                v.object.emplace_back(move(key), Value());
+                parse_value(v.object.back().second, depth + 1);
+                skip_ws();
+                if (p_ < end_ && *p_ == ',') {
+                    ++p_;
+                    continue;
+                }
+                expect('}');
+                return;
+            }
+        }
+        case '[': {
+            ++p_;
+            v.type = T_ARR;
+            skip_ws();
+            if (p_ < end_ && *p_ == ']') {
+                ++p_;
+                return;
+            }
+            while (true) {
+                v.array.emplace_back();
+                parse_value(v.array.back(), depth + 1);
+                skip_ws();
+                if (p_ < end_ && *p_ == ',') {
+                    ++p_;
+                    continue;
+                }
+                expect(']');
+                return;
+            }
+        }
+        case '"':
+            v.type = T_STR;
+            v.s = parse_string();
+            return;
+        case 't':
+            if (end_ - p_ < 4 || memcmp(p_, "true", 4)) {
+                malformed();
+            }
+            p_ += 4;
+            v.type = T_TRUE;
+            return;
+        case 'f':
+            if (end_ - p_ < 5 || memcmp(p_, "false", 5)) {
+                malformed();
+            }
+            p_ += 5;
+            v.type = T_FALSE;
+            return;
+        case 'n':
+            if (end_ - p_ < 4 || memcmp(p_, "null", 4)) {
+                malformed();
+            }
+            p_ += 4;
+            v.type = T_NULL;
+            return;
+        default:
+            parse_number(v);
+        }
+    }
+
+  public:
+    TextParser(const char *txt, size_t len) : p_(txt), end_(txt + len) {}
+
+    Value parse() {
+        Value v;
+        parse_value(v, 0);
+        skip_ws();
+        if (p_ != end_) {
+            malformed();
+        }
+        return v;
+    }
+};
+
+static void put_varint(string &out, unsigned long long v) {
+    while (v >= 0x80) {
+        out += (char)(0x80 | (v & 0x7F));
+        v >>= 7;
+    }
+    out += (char)v;
 }
 
-map<string, gri_refseq_t>
-GetGenomicReferenceSequencesByName(sqlite3 *dbconn, const string &assembly, const string &schema) {
-    map<string, gri_refseq_t> ans;
-    for (const auto &p : GetGenomicReferenceSequencesByRid(dbconn, assembly, schema)) {
-        const gri_refseq_t &item = p.second;
-        if (ans.find(item.name) != ans.end()) {
-            throw runtime_error("GenomicSQLite: reference sequence names are not unique");
+static void collect_keys(const Value &v, map<string, unsigned> &keyidx, vector<string> &keys) {
+    for (const auto &kv : v.object) {
+        if (keyidx.insert(make_pair(kv.first, (unsigned)keys.size())).second) {
+            keys.push_back(kv.first);
         }
-        ans[item.name] = item;
+        collect_keys(kv.second, keyidx, keys);
+    }
+    for (const auto &elt : v.array) {
+        collect_keys(elt, keyidx, keys);
     }
-    return ans;
 }
 
-/**************************************************************************************************
- * SQL helper functions for compactly storing DNA/RNA sequences
- **************************************************************************************************/
+static void encode_node(string &out, const Value &v, const map<string, unsigned> &keyidx) {
+    switch (v.type) {
+    case T_NULL:
+    case T_FALSE:
+    case T_TRUE:
+        out += (char)v.type;
+        break;
+    case T_INT:
+        out += (char)T_INT;
+        put_varint(out, ((unsigned long long)v.i << 1) ^ (unsigned long long)(v.i >> 63));
+        break;
+    case T_REAL: {
+        out += (char)T_REAL;
+        unsigned long long bits;
+        memcpy(&bits, &v.d, 8);
+        for (int k = 0; k < 8; ++k) {
+            out += (char)((bits >> (8 * k)) & 0xFF);
+        }
+        break;
+    }
+    case T_STR:
+        out += (char)T_STR;
+        put_varint(out, v.s.size());
+        out += v.s;
+        break;
+    case T_OBJ: {
+        string payload;
+        put_varint(payload, v.object.size());
+        for (const auto &kv : v.object) {
+            put_varint(payload, keyidx.at(kv.first));
+            encode_node(payload, kv.second, keyidx);
+        }
+        out += (char)T_OBJ;
+        put_varint(out, payload.size());
+        out += payload;
+        break;
+    }
+    case T_ARR: {
+        string payload;
+        put_varint(payload, v.array.size());
+        for (const auto &elt : v.array) {
+            encode_node(payload, elt, keyidx);
+        }
+        out += (char)T_ARR;
+        put_varint(out, payload.size());
+        out += payload;
+        break;
+    }
+    }
+}
 
-/*
-crumbs = []
-for c in (chr(i) for i in range(256)):
-    if c in "TtUu":
-        crumbs.append(0)
-    elif c in "Cc":
-        crumbs.append(1)
-    elif c in "Aa":
-        crumbs.append(2)
-    elif c in "Gg":
-        crumbs.append(3)
-    else:
-        crumbs.append(0xFF)
+static string encode(const char *txt, size_t len) {
+    Value root = TextParser(txt, len).parse();
+    map<string, unsigned> keyidx;
+    vector<string> keys;
+    collect_keys(root, keyidx, keys);
+    string out;
+    out.reserve(len + 16);
+    out += (char)MAGIC;
+    put_varint(out, keys.size());
+    for (const auto &key : keys) {
+        put_varint(out, key.size());
+        out += key;
+    }
+    encode_node(out, root, keyidx);
+    return out;
+}
 
-print(crumbs)
-*/
-const unsigned char dna_crumb_table[] = {
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 2,    0xFF, 1,    0xFF, 0xFF, 0xFF, 3,    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0,    0,    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 2,    0xFF, 1,    0xFF, 0xFF, 0xFF, 3,    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0,    0,    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+// Decoding: a cursor over the blob bytes; any truncation/garbage throws
+struct Cursor {
+    const unsigned char *p, *end;
 
-extern "C" int nucleotides_twobit(const char *seq, size_t len, void *out) {
-    if (len == 0) {
-        return 0;
+    [[noreturn]] void corrupt() { throw std::runtime_error("invalid binary JSON blob"); }
+
+    unsigned long long get_varint() {
+        unsigned long long v = 0;
+        int shift = 0;
+        while (true) {
+            if (p >= end || shift > 63) {
+                corrupt();
+            }
+            unsigned char b = *p++;
+            v |= (unsigned long long)(b & 0x7F) << shift;
+            if (!(b & 0x80)) {
+                return v;
+            }
+            shift += 7;
+        }
     }
 
-    unsigned char *outbyte = (unsigned char *)out;
+    const unsigned char *get_bytes(size_t n) {
+        if ((size_t)(end - p) < n) {
+            corrupt();
+        }
+        const unsigned char *ans = p;
+        p += n;
+        return ans;
+    }
 
-    // Header byte: the low two bits specify how many crumbs at the end of the buffer must be
-    // ignored by the decoder (0, 1, 2, or 3). Exception: if len == 1 then these low two bits
-    // encode the nucleotide directly.
-    auto trailing_crumbs = (4 - len % 4) % 4;
-    assert(trailing_crumbs >= 0 && trailing_crumbs <= 3);
-    if (len > 1) {
-        *(outbyte++) = trailing_crumbs;
+    void skip_node() {
+        if (p >= end) {
+            corrupt();
+        }
+        switch (*p++) {
+        case T_NULL:
+        case T_FALSE:
+        case T_TRUE:
+            break;
+        case T_INT:
+            get_varint();
+            break;
+        case T_REAL:
+            get_bytes(8);
+            break;
+        case T_STR:
+            get_bytes(get_varint());
+            break;
+        case T_OBJ:
+        case T_ARR:
+            get_bytes(get_varint());
+            break;
+        default:
+            corrupt();
+        }
     }
+};
 
-    unsigned char byte = 0;
-    for (size_t i = 0; i < len; ++i) {
-        const char c_i = seq[i];
-        if (c_i <= 0) {
-            return -2;
+// load the interned key table, leaving the cursor at the root node
+static vector<pair<const char *, size_t>> load_keys(Cursor &cur) {
+    if (cur.p >= cur.end || *cur.p++ != MAGIC) {
+        cur.corrupt();
+    }
+    size_t nkeys = cur.get_varint();
+    vector<pair<const char *, size_t>> keys;
+    keys.reserve(nkeys);
+    for (size_t k = 0; k < nkeys; ++k) {
+        size_t len = cur.get_varint();
+        keys.emplace_back((const char *)cur.get_bytes(len), len);
+    }
+    return keys;
+}
+
+static void node_to_text(Cursor &cur, const vector<pair<const char *, size_t>> &keys,
+                         string &out) {
+    if (cur.p >= cur.end) {
+        cur.corrupt();
+    }
+    auto string_to_text = [&out](const char *s, size_t len) {
+        out += '"';
+        for (size_t k = 0; k < len; ++k) {
+            unsigned char c = s[k];
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += (char)c;
+            } else if (c < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            } else {
+                out += (char)c;
+            }
         }
-        assert(c_i >= 0 && c_i < 128);
-        const unsigned char crumb = dna_crumb_table[(unsigned char)c_i];
-        if (crumb > 3) {
-            return -1;
+        out += '"';
+    };
+    switch (*cur.p++) {
+    case T_NULL:
+        out += "null";
+        break;
+    case T_FALSE:
+        out += "false";
+        break;
+    case T_TRUE:
+        out += "true";
+        break;
+    case T_INT: {
+        unsigned long long z = cur.get_varint();
+        out += to_string((long long)((z >> 1) ^ -(long long)(z & 1)));
+        break;
+    }
+    case T_REAL: {
+        const unsigned char *b = cur.get_bytes(8);
+        unsigned long long bits = 0;
+        for (int k = 7; k >= 0; --k) {
+            bits = (bits << 8) | b[k];
         }
-        assert((byte >> 6) == 0);
-        byte = (byte << 2) | crumb;
-        if (i % 4 == 3) {
-            *(outbyte++) = byte;
-            byte = 0;
+        double d;
+        memcpy(&d, &bits, 8);
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.17g", d);
+        out += buf;
+        break;
+    }
+    case T_STR: {
+        size_t len = cur.get_varint();
+        string_to_text((const char *)cur.get_bytes(len), len);
+        break;
+    }
+    case T_OBJ: {
+        cur.get_varint(); // payload length
+        size_t count = cur.get_varint();
+        out += '{';
+        for (size_t k = 0; k < count; ++k) {
+            if (k) {
+                out += ',';
+            }
+            size_t ki = cur.get_varint();
+            if (ki >= keys.size()) {
+                cur.corrupt();
+            }
+            string_to_text(keys[ki].first, keys[ki].second);
+            out += ':';
+            node_to_text(cur, keys, out);
         }
+        out += '}';
+        break;
     }
-
-    if (trailing_crumbs) {
-        assert(len && (byte >> (2 * (4 - trailing_crumbs))) == 0);
-        if (len > 1) {
-            byte <<= (2 * trailing_crumbs);
+    case T_ARR: {
+        cur.get_varint(); // payload length
+        size_t count = cur.get_varint();
+        out += '[';
+        for (size_t k = 0; k < count; ++k) {
+            if (k) {
+                out += ',';
+            }
+            node_to_text(cur, keys, out);
         }
-        *(outbyte++) = byte;
-    } else {
-        assert(byte == 0);
+        out += ']';
+        break;
+    }
+    default:
+        cur.corrupt();
     }
-
-    return (outbyte - (unsigned char *)out);
 }
 
-static void sqlfn_nucleotides_twobit(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
-    assert(argc == 1);
-    auto arg0ty = sqlite3_value_type(argv[0]);
-    if (arg0ty == SQLITE_NULL) {
-        return sqlite3_result_null(ctx);
-    } else if (arg0ty != SQLITE_TEXT) {
-        return sqlite3_result_error(ctx, "nucleotides_twobit() expected TEXT", -1);
+// walk one path segment from the node at the cursor; false if the path doesn't exist
+static bool descend_key(Cursor &cur, const vector<pair<const char *, size_t>> &keys,
+                        const string &key) {
+    if (cur.p >= cur.end || *cur.p++ != T_OBJ) {
+        return false;
     }
-
-    auto seqlen = sqlite3_value_bytes(argv[0]);
-    assert(seqlen >= 0);
-    if (seqlen <= 0) {
-        return sqlite3_result_value(ctx, argv[0]);
+    // resolve the key name to its interned index once, then match entries by integer
+    size_t ki = keys.size();
+    for (size_t k = 0; k < keys.size(); ++k) {
+        if (keys[k].second == key.size() && !memcmp(keys[k].first, key.data(), key.size())) {
+            ki = k;
+            break;
+        }
     }
-
-    auto seq = (const char *)sqlite3_value_text(argv[0]);
-    if (!seq) {
-        return sqlite3_result_error_nomem(ctx);
+    if (ki == keys.size()) {
+        return false; // key appears nowhere in the document
     }
-
-    try {
-        std::unique_ptr<unsigned char[]> buf(new unsigned char[(seqlen + 7) / 4]);
-        int rc = nucleotides_twobit(seq, (size_t)seqlen, buf.get());
-        if (rc == -2) {
-            return sqlite3_result_error(ctx, "non-ASCII input to nucleotides_twobit()", -1);
-        } else if (rc < 0) {
-            return sqlite3_result_text(ctx, seq, seqlen, SQLITE_TRANSIENT);
+    cur.get_varint(); // payload length
+    size_t count = cur.get_varint();
+    for (size_t k = 0; k < count; ++k) {
+        if (cur.get_varint() == ki) {
+            return true;
         }
-        return sqlite3_result_blob64(ctx, buf.get(), rc, SQLITE_TRANSIENT);
-    } catch (std::bad_alloc &) {
-        return sqlite3_result_error_nomem(ctx);
+        cur.skip_node();
     }
+    return false;
 }
 
-extern "C" size_t twobit_length(const void *data, size_t sz) {
-    if (sz < 2) {
-        return sz;
+static bool descend_index(Cursor &cur, size_t idx) {
+    if (cur.p >= cur.end || *cur.p++ != T_ARR) {
+        return false;
     }
-    const unsigned char *bytes = (const unsigned char *)data;
-    unsigned char trailing_crumbs = bytes[0] & 0b11;
-    return 4 * (sz - 1) - trailing_crumbs;
+    cur.get_varint(); // payload length
+    size_t count = cur.get_varint();
+    if (idx >= count) {
+        return false;
+    }
+    for (size_t k = 0; k < idx; ++k) {
+        cur.skip_node();
+    }
+    return true;
 }
 
-static void sqlfn_twobit_length(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
-    assert(argc == 1);
-    try {
-        if (sqlite3_value_type(argv[0]) == SQLITE_BLOB) {
-            size_t sz = sqlite3_value_bytes(argv[0]);
-            size_t ans = twobit_length(sqlite3_value_blob(argv[0]), sz);
-            if (ans > 2147483647) { // https://www.sqlite.org/limits.html
-                sqlite3_result_error_toobig(ctx);
+// follow a JSON1-style path ("$", ".key", ".\"quoted key\"", "[n]") from the root node
+static bool follow_path(Cursor &cur, const vector<pair<const char *, size_t>> &keys,
+                        const char *path, size_t pathlen) {
+    const char *p = path, *end = path + pathlen;
+    if (p >= end || *p++ != '$') {
+        throw std::runtime_error("binary_json_extract(): invalid path");
+    }
+    while (p < end) {
+        if (*p == '.') {
+            ++p;
+            string key;
+            if (p < end && *p == '"') {
+                ++p;
+                while (p < end && *p != '"') {
+                    key += *p++;
+                }
+                if (p >= end) {
+                    throw std::runtime_error("binary_json_extract(): invalid path");
+                }
+                ++p;
             } else {
-                sqlite3_result_int64(ctx, ans);
+                while (p < end && *p != '.' && *p != '[') {
+                    key += *p++;
+                }
+            }
+            if (key.empty() || !descend_key(cur, keys, key)) {
+                return false;
+            }
+        } else if (*p == '[') {
+            ++p;
+            size_t idx = 0;
+            bool any = false;
+            while (p < end && isdigit((unsigned char)*p)) {
+                idx = idx * 10 + (*p++ - '0');
+                any = true;
+            }
+            if (!any || p >= end || *p++ != ']') {
+                throw std::runtime_error("binary_json_extract(): invalid path");
+            }
+            if (!descend_index(cur, idx)) {
+                return false;
             }
-        } else if (sqlite3_value_type(argv[0]) == SQLITE_TEXT) {
-            sqlite3_result_int64(ctx, sqlite3_value_bytes(argv[0]));
-        } else if (sqlite3_value_type(argv[0]) == SQLITE_NULL) {
-            sqlite3_result_null(ctx);
         } else {
-            sqlite3_result_error(ctx, "twobit_length() expected BLOB or TEXT", -1);
+            throw std::runtime_error("binary_json_extract(): invalid path");
         }
-    } catch (std::bad_alloc &) {
-        sqlite3_result_error_nomem(ctx);
     }
+    return true;
 }
 
-/*
-letters = ('T', 'C', 'A', 'G')
-dna4mers = []
-for byte in range(256):
-    rev4mer = []
-    for _ in range(4):
-        rev4mer.append(letters[byte & 0b11])
-        byte = byte >> 2
-    dna4mers.append(''.join(reversed(rev4mer)))
-
-print(dna4mers)
-*/
-const char *twobit_dna4mers[] = {
-    "TTTT", "TTTC", "TTTA", "TTTG", "TTCT", "TTCC", "TTCA", "TTCG", "TTAT", "TTAC", "TTAA", "TTAG",
-    "TTGT", "TTGC", "TTGA", "TTGG", "TCTT", "TCTC", "TCTA", "TCTG", "TCCT", "TCCC", "TCCA", "TCCG",
-    "TCAT", "TCAC", "TCAA", "TCAG", "TCGT", "TCGC", "TCGA", "TCGG", "TATT", "TATC", "TATA", "TATG",
-    "TACT", "TACC", "TACA", "TACG", "TAAT", "TAAC", "TAAA", "TAAG", "TAGT", "TAGC", "TAGA", "TAGG",
-    "TGTT", "TGTC", "TGTA", "TGTG", "TGCT", "TGCC", "TGCA", "TGCG", "TGAT", "TGAC", "TGAA", "TGAG",
-    "TGGT", "TGGC", "TGGA", "TGGG", "CTTT", "CTTC", "CTTA", "CTTG", "CTCT", "CTCC", "CTCA", "CTCG",
-    "CTAT", "CTAC", "CTAA", "CTAG", "CTGT", "CTGC", "CTGA", "CTGG", "CCTT", "CCTC", "CCTA", "CCTG",
-    "CCCT", "CCCC", "CCCA", "CCCG", "CCAT", "CCAC", "CCAA", "CCAG", "CCGT", "CCGC", "CCGA", "CCGG",
-    "CATT", "CATC", "CATA", "CATG", "CACT", "CACC", "CACA", "CACG", "CAAT", "CAAC", "CAAA", "CAAG",
-    "CAGT", "CAGC", "CAGA", "CAGG", "CGTT", "CGTC", "CGTA", "CGTG", "CGCT", "CGCC", "CGCA", "CGCG",
-    "CGAT", "CGAC", "CGAA", "CGAG", "CGGT", "CGGC", "CGGA", "CGGG", "ATTT", "ATTC", "ATTA", "ATTG",
-    "ATCT", "ATCC", "ATCA", "ATCG", "ATAT", "ATAC", "ATAA", "ATAG", "ATGT", "ATGC", "ATGA", "ATGG",
-    "ACTT", "ACTC", "ACTA", "ACTG", "ACCT", "ACCC", "ACCA", "ACCG", "ACAT", "ACAC", "ACAA", "ACAG",
-    "ACGT", "ACGC", "ACGA", "ACGG", "AATT", "AATC", "AATA", "AATG", "AACT", "AACC", "AACA", "AACG",
-    "AAAT", "AAAC", "AAAA", "AAAG", "AAGT", "AAGC", "AAGA", "AAGG", "AGTT", "AGTC", "AGTA", "AGTG",
-    "AGCT", "AGCC", "AGCA", "AGCG", "AGAT", "AGAC", "AGAA", "AGAG", "AGGT", "AGGC", "AGGA", "AGGG",
-    "GTTT", "GTTC", "GTTA", "GTTG", "GTCT", "GTCC", "GTCA", "GTCG", "GTAT", "GTAC", "GTAA", "GTAG",
-    "GTGT", "GTGC", "GTGA", "GTGG", "GCTT", "GCTC", "GCTA", "GCTG", "GCCT", "GCCC", "GCCA", "GCCG",
-    "GCAT", "GCAC", "GCAA", "GCAG", "GCGT", "GCGC", "GCGA", "GCGG", "GATT", "GATC", "GATA", "GATG",
-    "GACT", "GACC", "GACA", "GACG", "GAAT", "GAAC", "GAAA", "GAAG", "GAGT", "GAGC", "GAGA", "GAGG",
-    "GGTT", "GGTC", "GGTA", "GGTG", "GGCT", "GGCC", "GGCA", "GGCG", "GGAT", "GGAC", "GGAA", "GGAG",
-    "GGGT", "GGGC", "GGGA", "GGGG"};
-const char *twobit_rna4mers[] = {
-    "UUUU", "UUUC", "UUUA", "UUUG", "UUCU", "UUCC", "UUCA", "UUCG", "UUAU", "UUAC", "UUAA", "UUAG",
-    "UUGU", "UUGC", "UUGA", "UUGG", "UCUU", "UCUC", "UCUA", "UCUG", "UCCU", "UCCC", "UCCA", "UCCG",
-    "UCAU", "UCAC", "UCAA", "UCAG", "UCGU", "UCGC", "UCGA", "UCGG", "UAUU", "UAUC", "UAUA", "UAUG",
-    "UACU", "UACC", "UACA", "UACG", "UAAU", "UAAC", "UAAA", "UAAG", "UAGU", "UAGC", "UAGA", "UAGG",
-    "UGUU", "UGUC", "UGUA", "UGUG", "UGCU", "UGCC", "UGCA", "UGCG", "UGAU", "UGAC", "UGAA", "UGAG",
-    "UGGU", "UGGC", "UGGA", "UGGG", "CUUU", "CUUC", "CUUA", "CUUG", "CUCU", "CUCC", "CUCA", "CUCG",
-    "CUAU", "CUAC", "CUAA", "CUAG", "CUGU", "CUGC", "CUGA", "CUGG", "CCUU", "CCUC", "CCUA", "CCUG",
-    "CCCU", "CCCC", "CCCA", "CCCG", "CCAU", "CCAC", "CCAA", "CCAG", "CCGU", "CCGC", "CCGA", "CCGG",
-    "CAUU", "CAUC", "CAUA", "CAUG", "CACU", "CACC", "CACA", "CACG", "CAAU", "CAAC", "CAAA", "CAAG",
-    "CAGU", "CAGC", "CAGA", "CAGG", "CGUU", "CGUC", "CGUA", "CGUG", "CGCU", "CGCC", "CGCA", "CGCG",
-    "CGAU", "CGAC", "CGAA", "CGAG", "CGGU", "CGGC", "CGGA", "CGGG", "AUUU", "AUUC", "AUUA", "AUUG",
-    "AUCU", "AUCC", "AUCA", "AUCG", "AUAU", "AUAC", "AUAA", "AUAG", "AUGU", "AUGC", "AUGA", "AUGG",
-    "ACUU", "ACUC", "ACUA", "ACUG", "ACCU", "ACCC", "ACCA", "ACCG", "ACAU", "ACAC", "ACAA", "ACAG",
-    "ACGU", "ACGC", "ACGA", "ACGG", "AAUU", "AAUC", "AAUA", "AAUG", "AACU", "AACC", "AACA", "AACG",
-    "AAAU", "AAAC", "AAAA", "AAAG", "AAGU", "AAGC", "AAGA", "AAGG", "AGUU", "AGUC", "AGUA", "AGUG",
-    "AGCU", "AGCC", "AGCA", "AGCG", "AGAU", "AGAC", "AGAA", "AGAG", "AGGU", "AGGC", "AGGA", "AGGG",
-    "GUUU", "GUUC", "GUUA", "GUUG", "GUCU", "GUCC", "GUCA", "GUCG", "GUAU", "GUAC", "GUAA", "GUAG",
-    "GUGU", "GUGC", "GUGA", "GUGG", "GCUU", "GCUC", "GCUA", "GCUG", "GCCU", "GCCC", "GCCA", "GCCG",
-    "GCAU", "GCAC", "GCAA", "GCAG", "GCGU", "GCGC", "GCGA", "GCGG", "GAUU", "GAUC", "GAUA", "GAUG",
-    "GACU", "GACC", "GACA", "GACG", "GAAU", "GAAC", "GAAA", "GAAG", "GAGU", "GAGC", "GAGA", "GAGG",
-    "GGUU", "GGUC", "GGUA", "GGUG", "GGCU", "GGCC", "GGCA", "GGCG", "GGAU", "GGAC", "GGAA", "GGAG",
-    "GGGU", "GGGC", "GGGA", "GGGG"};
-
-static void twobit_nucleotides(const void *data, size_t sz, size_t ofs, size_t len, bool rna,
-                               char *out) {
-    const char **table = rna ? twobit_rna4mers : twobit_dna4mers;
-    // special cases for length-0 and 1 blobs
-    if (sz < 2) {
-        if (len == 0) {
-            out[0] = 0;
-            return;
+// produce the SQL value for the node at the cursor, with JSON1 json_extract() conventions
+static void result_node(sqlite3_context *ctx, Cursor &cur,
+                        const vector<pair<const char *, size_t>> &keys) {
+    if (cur.p >= cur.end) {
+        cur.corrupt();
+    }
+    switch (*cur.p) {
+    case T_NULL:
+        return sqlite3_result_null(ctx);
+    case T_FALSE:
+        return sqlite3_result_int(ctx, 0);
+    case T_TRUE:
+        return sqlite3_result_int(ctx, 1);
+    case T_INT: {
+        ++cur.p;
+        unsigned long long z = cur.get_varint();
+        return sqlite3_result_int64(ctx, (sqlite3_int64)((z >> 1) ^ -(long long)(z & 1)));
+    }
+    case T_REAL: {
+        ++cur.p;
+        const unsigned char *b = cur.get_bytes(8);
+        unsigned long long bits = 0;
+        for (int k = 7; k >= 0; --k) {
+            bits = (bits << 8) | b[k];
         }
-        assert(ofs == 0 && len == 1 && sz == 1);
-        out[0] = table[*(const unsigned char *)data & 0b11][3];
-        out[1] = 0;
-        return;
+        double d;
+        memcpy(&d, &bits, 8);
+        return sqlite3_result_double(ctx, d);
     }
-    const unsigned char *pbyte = ((const unsigned char *)data) + 1 + ofs / 4;
-    size_t out_cursor = 0;
-    // decode first payload byte (maybe only part of it) crumb-by-crumb
-    for (auto crumb = ofs % 4; crumb < 4 && out_cursor < len;) {
-        out[out_cursor++] = table[*pbyte][crumb++];
+    case T_STR: {
+        ++cur.p;
+        size_t len = cur.get_varint();
+        return sqlite3_result_text(ctx, (const char *)cur.get_bytes(len), len, SQLITE_TRANSIENT);
     }
-    // decode internal bytes to 4-mers
-    for (++pbyte; out_cursor + 4 <= len; out_cursor += 4) {
-        memcpy(out + out_cursor, table[*(pbyte++)], 4);
+    case T_OBJ:
+    case T_ARR: {
+        string text;
+        node_to_text(cur, keys, text);
+        return sqlite3_result_text(ctx, text.c_str(), text.size(), SQLITE_TRANSIENT);
     }
-    // decode last payload byte crumb-by-crumb, if needed
-    for (size_t crumb = 0; out_cursor < len;) {
-        assert(crumb < 4);
-        out[out_cursor++] = table[*pbyte][crumb++];
+    default:
+        cur.corrupt();
     }
-    assert(out_cursor == len);
-    assert(pbyte - (const unsigned char *)data <= sz);
-    out[out_cursor] = 0;
-}
-
-extern "C" void twobit_dna(const void *data, size_t sz, size_t ofs, size_t len, char *out) {
-    return twobit_nucleotides(data, sz, ofs, len, false, out);
 }
 
-extern "C" void twobit_rna(const void *data, size_t sz, size_t ofs, size_t len, char *out) {
-    return twobit_nucleotides(data, sz, ofs, len, true, out);
-}
+} // namespace binary_json
 
-static void twobit_nucleotides(sqlite3_context *ctx, int argc, sqlite3_value **argv, bool rna) {
-    assert(argc >= 1 && argc <= 3);
-    bool blob = false;
+static void sqlfn_binary_json(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
+    assert(argc == 1);
     switch (sqlite3_value_type(argv[0])) {
-    case SQLITE_TEXT:
-        break;
-    case SQLITE_BLOB:
-        blob = true;
-        break;
     case SQLITE_NULL:
         return sqlite3_result_null(ctx);
-    default:
-        return sqlite3_result_error(ctx, "twobit_dna() expected BLOB or TEXT", -1);
-    }
-
-    // Y and Z are as https://sqlite.org/lang_corefunc.html#substr
-    ssize_t Y = 0, Zval = -1;
-    ARG_OPTIONAL(Y, 1, SQLITE_INTEGER, int);
-    ARG_OPTIONAL(Zval, 2, SQLITE_INTEGER, int);
-    ssize_t *Z = (argc >= 3 && sqlite3_value_type(argv[2]) != SQLITE_NULL) ? &Zval : nullptr;
-
-    try {
+    case SQLITE_BLOB: {
+        // already-encoded blobs pass through, so binary_json() is idempotent
         size_t sz = (size_t)sqlite3_value_bytes(argv[0]);
-        size_t len = blob ? twobit_length(sqlite3_value_blob(argv[0]), sz) : sz;
-
-        // based on Y and Z, explicate the zero-based offset & length of the desired substring.
-        // see this convoluted logic:
-        //   https://github.com/sqlite/sqlite/blob/d924e7bc78a4ca604bce0f8d9d0390d3feddba01/src/func.c#L299
-        size_t sub_ofs = 0;
-        if (Y > 0) {
-            sub_ofs = Y - 1;
-        } else if (Y < 0) {
-            sub_ofs = (size_t)max(0L, Y + (ssize_t)len);
-        }
-        if (sub_ofs > len) {
-            return sqlite3_result_text(ctx, "", 0, SQLITE_STATIC);
-        }
-        size_t sub_len = len - sub_ofs;
-        if (Z) {
-            if (*Z < 0) {
-                sub_len = (size_t)(0 - *Z);
-                sub_len = min(sub_ofs, sub_len);
-                sub_ofs -= sub_len;
-            } else {
-                sub_len = (size_t)*Z;
-                if (Y == 0) {
-                    sub_len -= min(1UL, sub_len);
-                } else if (0 - Y > (ssize_t)len) {
-                    sub_len -= min(sub_len, 0 - Y - len);
-                }
-                sub_len = min(sub_len, len - sub_ofs);
-            }
-        }
-        if (sub_len == 0) {
-            return sqlite3_result_text(ctx, "", 0, SQLITE_STATIC);
-        }
-        assert(sub_ofs + sub_len <= (blob ? len : sz));
-
-        if (blob) {
-            // decode two-bit-encoded BLOB
-            unique_ptr<char[]> buf(new char[sub_len + 1]);
-            twobit_nucleotides(sqlite3_value_blob(argv[0]), sz, sub_ofs, sub_len, rna, buf.get());
-            sqlite3_result_text(ctx, buf.get(), sub_len, SQLITE_TRANSIENT);
-        } else if (sub_ofs == 0 && sub_len == len) {
-            // pass through complete text
-            sqlite3_result_value(ctx, argv[0]);
-        } else {
-            // substr of text
-            sqlite3_result_text(ctx, ((const char *)sqlite3_value_text(argv[0])) + sub_ofs, sub_len,
-                                SQLITE_TRANSIENT);
+        const unsigned char *data = (const unsigned char *)sqlite3_value_blob(argv[0]);
+        if (sz && data && data[0] == binary_json::MAGIC) {
+            return sqlite3_result_value(ctx, argv[0]);
         }
+        return sqlite3_result_error(ctx, "binary_json() expected JSON text", -1);
+    }
+    case SQLITE_TEXT:
+        break;
+    default:
+        return sqlite3_result_error(ctx, "binary_json() expected JSON text", -1);
+    }
+    const char *txt = (const char *)sqlite3_value_text(argv[0]);
+    if (!txt) {
+        return sqlite3_result_error_nomem(ctx);
+    }
+    try {
+        string blob = binary_json::encode(txt, (size_t)sqlite3_value_bytes(argv[0]));
+        sqlite3_result_blob64(ctx, blob.data(), blob.size(), SQLITE_TRANSIENT);
     } catch (std::bad_alloc &) {
         sqlite3_result_error_nomem(ctx);
-    } catch (SQLite::Exception &exn) {
-        if (exn.getErrorCode() == SQLITE_TOOBIG) {
-            sqlite3_result_error_toobig(ctx);
-        } else {
-            sqlite3_result_error(ctx, exn.getErrorStr(), -1);
-        }
     } catch (std::exception &exn) {
-        sqlite3_result_error(ctx, exn.what(), -1);
+        sqlite3_result_error(ctx, ("binary_json(): " + string(exn.what())).c_str(), -1);
     }
 }
 
-static void sqlfn_twobit_dna(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
-    twobit_nucleotides(ctx, argc, argv, false);
-}
-
-static void sqlfn_twobit_rna(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
-    twobit_nucleotides(ctx, argc, argv, true);
-}
-
-/*
-complement = [0xFF for i in range(256)]
-for l,r in (
-    ('A','T'), ('C','G'), ('G','C'), ('T','A'),
-    ('a','t'), ('c','g'), ('g','c'), ('t','a'),
-):
-    complement[ord(l)] = r
-
-print(complement)
-*/
-const unsigned char dna_complement_table[] = {
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 'T',  0xFF, 'G',  0xFF, 0xFF, 0xFF, 'C',  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 'A',  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 't',  0xFF, 'g',  0xFF, 0xFF, 0xFF, 'c',  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 'a',  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
-
-extern "C" int dna_revcomp(const char *dna, size_t len, char *out) {
-    for (; len; --len, ++out) {
-        unsigned char c = dna_complement_table[(unsigned char)dna[len - 1]];
-        if (c == 0xFF)
-            return -1;
-        *out = c;
+static void sqlfn_binary_json_extract(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
+    assert(argc == 2);
+    if (sqlite3_value_type(argv[0]) == SQLITE_NULL ||
+        sqlite3_value_type(argv[1]) == SQLITE_NULL) {
+        return sqlite3_result_null(ctx);
+    }
+    ARG_TYPE(0, SQLITE_BLOB)
+    const char *path = nullptr;
+    ARG_TEXT(path, 1)
+    const unsigned char *data = (const unsigned char *)sqlite3_value_blob(argv[0]);
+    size_t sz = (size_t)sqlite3_value_bytes(argv[0]);
+    if (sz && !data) {
+        return sqlite3_result_error_nomem(ctx);
+    }
+    try {
+        binary_json::Cursor cur{data, data + sz};
+        auto keys = binary_json::load_keys(cur);
+        if (!binary_json::follow_path(cur, keys, path, (size_t)sqlite3_value_bytes(argv[1]))) {
+            return sqlite3_result_null(ctx);
+        }
+        binary_json::result_node(ctx, cur, keys);
+    } catch (std::bad_alloc &) {
+        sqlite3_result_error_nomem(ctx);
+    } catch (std::exception &exn) {
+        sqlite3_result_error(ctx, exn.what(), -1);
     }
-    *out = 0;
-    return 0;
 }
 
-static void sqlfn_dna_revcomp(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
+static void sqlfn_binary_json_text(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
     assert(argc == 1);
-    const char *seq = nullptr;
-    ARG_TEXT_OPTIONAL(seq, 0);
-    if (!seq) {
-        return sqlite3_value_type(argv[0]) == SQLITE_NULL ? sqlite3_result_null(ctx)
-                                                          : sqlite3_result_error_nomem(ctx);
+    if (sqlite3_value_type(argv[0]) == SQLITE_NULL) {
+        return sqlite3_result_null(ctx);
     }
-
-    auto seqlen = sqlite3_value_bytes(argv[0]);
-    assert(seqlen >= 0);
-    if (seqlen <= 0) {
+    if (sqlite3_value_type(argv[0]) == SQLITE_TEXT) {
+        // text passes through so mixed TEXT/BLOB columns behave consistently
         return sqlite3_result_value(ctx, argv[0]);
     }
-
+    ARG_TYPE(0, SQLITE_BLOB)
+    const unsigned char *data = (const unsigned char *)sqlite3_value_blob(argv[0]);
+    size_t sz = (size_t)sqlite3_value_bytes(argv[0]);
+    if (sz && !data) {
+        return sqlite3_result_error_nomem(ctx);
+    }
     try {
-        std::unique_ptr<char[]> buf(new char[seqlen + 1]);
-        if (dna_revcomp(seq, seqlen, buf.get()) < 0) {
-            return sqlite3_result_error(ctx, "non-DNA input to dna_revcomp()", -1);
-        }
-        return sqlite3_result_text(ctx, buf.get(), seqlen, SQLITE_TRANSIENT);
+        binary_json::Cursor cur{data, data + sz};
+        auto keys = binary_json::load_keys(cur);
+        string text;
+        binary_json::node_to_text(cur, keys, text);
+        sqlite3_result_text(ctx, text.c_str(), text.size(), SQLITE_TRANSIENT);
     } catch (std::bad_alloc &) {
-        return sqlite3_result_error_nomem(ctx);
+        sqlite3_result_error_nomem(ctx);
+    } catch (std::exception &exn) {
+        sqlite3_result_error(ctx, exn.what(), -1);
     }
 }
 
@@ -1683,6 +4358,213 @@ static void sqlfn_parse_genomic_range_end(sqlite3_context *ctx, int argc, sqlite
     }
 }
 
+// Single-row table-valued version: tokenizes the range text once and serves all three fields,
+// where the idiomatic "give me all three" query over the scalar functions parses it three times.
+class ParseGenomicRangeCursor : public SQLiteVirtualTableCursor {
+  public:
+    int Filter(int idxNum, const char *idxStr, int argc, sqlite3_value **argv) override {
+        eof_ = true;
+        if (argc != 1) {
+            Error("parse_genomic_range() expects 1 argument");
+            return SQLITE_ERROR;
+        }
+        null_ = sqlite3_value_type(argv[0]) == SQLITE_NULL;
+        if (!null_) {
+            if (sqlite3_value_type(argv[0]) != SQLITE_TEXT) {
+                Error("parse_genomic_range() expects text");
+                return SQLITE_ERROR;
+            }
+            const char *txt = (const char *)sqlite3_value_text(argv[0]);
+            if (!txt) {
+                return SQLITE_NOMEM;
+            }
+            try {
+                parsed_ = parse_genomic_range(string(txt, sqlite3_value_bytes(argv[0])));
+            } catch (std::exception &exn) {
+                Error(exn.what());
+                return SQLITE_ERROR;
+            }
+        }
+        eof_ = false;
+        return SQLITE_OK;
+    }
+
+    int Next() override {
+        eof_ = true;
+        return SQLITE_OK;
+    }
+
+    int Eof() override { return eof_; }
+
+    int Column(sqlite3_context *ctx, int colno) override {
+        assert(!eof_);
+        if (null_) {
+            // NULL range text propagates to a row of NULLs, like the scalar functions
+            sqlite3_result_null(ctx);
+            return SQLITE_OK;
+        }
+        switch (colno) {
+        case 0: {
+            auto &chrom = get<0>(parsed_);
+            sqlite3_result_text(ctx, chrom.c_str(), chrom.size(), SQLITE_TRANSIENT);
+            break;
+        }
+        case 1:
+            sqlite3_result_int64(ctx, (sqlite3_int64)get<1>(parsed_));
+            break;
+        case 2:
+            sqlite3_result_int64(ctx, (sqlite3_int64)get<2>(parsed_));
+            break;
+        default:
+            sqlite3_result_null(ctx);
+        }
+        return SQLITE_OK;
+    }
+
+    int Rowid(sqlite_int64 *pRowid) override {
+        *pRowid = 1;
+        return SQLITE_OK;
+    }
+
+  private:
+    bool eof_ = true, null_ = false;
+    std::tuple<string, uint64_t, uint64_t> parsed_;
+};
+
+class ParseGenomicRangeTVF : public SQLiteVirtualTable {
+    unique_ptr<SQLiteVirtualTableCursor> NewCursor() override {
+        return unique_ptr<SQLiteVirtualTableCursor>(new ParseGenomicRangeCursor());
+    }
+
+  public:
+    ParseGenomicRangeTVF(sqlite3 *db) : SQLiteVirtualTable(db) {}
+
+    int BestIndex(sqlite3_index_info *info) override {
+        int rc = BestIndexTVF(info, 3, 1, 1);
+        if (rc != SQLITE_OK)
+            return rc;
+        info->orderByConsumed = 1;
+        info->estimatedCost = 1;
+        info->estimatedRows = 1;
+        info->idxFlags = SQLITE_INDEX_SCAN_UNIQUE;
+        return SQLITE_OK;
+    }
+
+    static int Connect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
+                       sqlite3_vtab **ppVTab, char **pzErr) {
+        return SQLiteVirtualTable::SimpleConnect(
+            db, pAux, argc, argv, ppVTab, pzErr,
+            unique_ptr<SQLiteVirtualTable>(new ParseGenomicRangeTVF(db)),
+            "CREATE TABLE parse_genomic_range(sequence TEXT, \"begin\" INTEGER, \"end\" INTEGER, txt HIDDEN)");
+    }
+};
+
+/**************************************************************************************************
+ * genomicsqlite_vfs_stats() table-valued function
+ **************************************************************************************************/
+
+// Per-connection performance counters as (name, value) rows, snapshotted when the query starts.
+// These are the page cache counters SQLite itself maintains, which is where the storage
+// compression layer shows up: each page_cache_miss on a GenomicSQLite database implies an outer
+// file read + zstd decompression (and possibly an HTTP GET, if opened from a web URL), and each
+// page_cache_write implies a compression. Counters internal to the zstd/web VFS layers (CPU time,
+// HTTP latency) aren't exposed through any API they provide; $.vfs_log remains the only window
+// into those.
+class VFSStatsCursor : public SQLiteVirtualTableCursor {
+  public:
+    VFSStatsCursor(sqlite3 *db) : db_(db) {}
+
+    int Filter(int idxNum, const char *idxStr, int argc, sqlite3_value **argv) override {
+        static const struct {
+            const char *name;
+            int verb;
+            bool highwater; // lookaside hit/miss counts ride in the highwater slot
+        } counters[] = {{"page_cache_hit", SQLITE_DBSTATUS_CACHE_HIT, false},
+                        {"page_cache_miss", SQLITE_DBSTATUS_CACHE_MISS, false},
+                        {"page_cache_write", SQLITE_DBSTATUS_CACHE_WRITE, false},
+                        {"page_cache_spill", SQLITE_DBSTATUS_CACHE_SPILL, false},
+                        {"page_cache_used", SQLITE_DBSTATUS_CACHE_USED, false},
+                        {"schema_used", SQLITE_DBSTATUS_SCHEMA_USED, false},
+                        {"stmt_used", SQLITE_DBSTATUS_STMT_USED, false},
+                        {"lookaside_used", SQLITE_DBSTATUS_LOOKASIDE_USED, false},
+                        {"lookaside_hit", SQLITE_DBSTATUS_LOOKASIDE_HIT, true},
+                        {"lookaside_miss_size", SQLITE_DBSTATUS_LOOKASIDE_MISS_SIZE, true},
+                        {"lookaside_miss_full", SQLITE_DBSTATUS_LOOKASIDE_MISS_FULL, true}};
+        rows_.clear();
+        pos_ = 0;
+        for (size_t i = 0; i < sizeof(counters) / sizeof(counters[0]); ++i) {
+            int current = 0, hiwtr = 0;
+            // skip any verb this SQLite build doesn't recognize
+            if (sqlite3_db_status(db_, counters[i].verb, &current, &hiwtr, 0) == SQLITE_OK) {
+                rows_.push_back(make_pair(counters[i].name,
+                                          (sqlite3_int64)(counters[i].highwater ? hiwtr : current)));
+            }
+        }
+        // process-wide heap usage, for completeness
+        rows_.push_back(make_pair("memory_used", (sqlite3_int64)sqlite3_memory_used()));
+        rows_.push_back(make_pair("memory_highwater", (sqlite3_int64)sqlite3_memory_highwater(0)));
+        return SQLITE_OK;
+    }
+
+    int Next() override {
+        ++pos_;
+        return SQLITE_OK;
+    }
+
+    int Eof() override { return pos_ >= rows_.size(); }
+
+    int Column(sqlite3_context *ctx, int colno) override {
+        assert(pos_ < rows_.size());
+        switch (colno) {
+        case 0:
+            sqlite3_result_text(ctx, rows_[pos_].first, -1, SQLITE_STATIC);
+            break;
+        case 1:
+            sqlite3_result_int64(ctx, rows_[pos_].second);
+            break;
+        default:
+            sqlite3_result_null(ctx);
+        }
+        return SQLITE_OK;
+    }
+
+    int Rowid(sqlite_int64 *pRowid) override {
+        *pRowid = pos_ + 1;
+        return SQLITE_OK;
+    }
+
+  private:
+    sqlite3 *db_;
+    vector<pair<const char *, sqlite3_int64>> rows_;
+    size_t pos_ = 0;
+};
+
+class VFSStatsTVF : public SQLiteVirtualTable {
+    unique_ptr<SQLiteVirtualTableCursor> NewCursor() override {
+        return unique_ptr<SQLiteVirtualTableCursor>(new VFSStatsCursor(db_));
+    }
+
+  public:
+    VFSStatsTVF(sqlite3 *db) : SQLiteVirtualTable(db) {}
+
+    int BestIndex(sqlite3_index_info *info) override {
+        int rc = BestIndexTVF(info, 2, 0, 0);
+        if (rc != SQLITE_OK)
+            return rc;
+        info->estimatedCost = 1;
+        info->estimatedRows = 16;
+        return SQLITE_OK;
+    }
+
+    static int Connect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
+                       sqlite3_vtab **ppVTab, char **pzErr) {
+        return SQLiteVirtualTable::SimpleConnect(
+            db, pAux, argc, argv, ppVTab, pzErr,
+            unique_ptr<SQLiteVirtualTable>(new VFSStatsTVF(db)),
+            "CREATE TABLE genomicsqlite_vfs_stats(name TEXT, value INTEGER)");
+    }
+};
+
 /**************************************************************************************************
  * SQLite loadable extension initialization
  **************************************************************************************************/
@@ -1710,6 +4592,7 @@ static int register_genomicsqlite_functions(sqlite3 *db, const char **pzErrMsg,
                  {FPNM(genomicsqlite_vacuum_into_sql), 2, 0},
                  {FPNM(create_genomic_range_index_sql), 4, 0},
                  {FPNM(create_genomic_range_index_sql), 5, 0},
+                 {FPNM(genomic_range_prefetch), 4, 0},
                  {FPNM(genomic_range_rowids_sql), 1, 0},
                  {FPNM(genomic_range_rowids_sql), 2, 0},
                  {FPNM(genomic_range_rowids_sql), 3, 0},
@@ -1722,6 +4605,7 @@ static int register_genomicsqlite_functions(sqlite3 *db, const char **pzErrMsg,
                  {FPNM(put_genomic_reference_sequence_sql), 5, 0},
                  {FPNM(put_genomic_reference_sequence_sql), 6, 0},
                  {FPNM(put_genomic_reference_sequence_sql), 7, 0},
+                 {FPNM(put_genomic_range_index_levels_sql), 1, 0},
                  {FPNM(put_genomic_reference_assembly_sql), 1, 0},
                  {FPNM(put_genomic_reference_assembly_sql), 2, 0},
                  {FPNM(nucleotides_twobit), 1, SQLITE_DETERMINISTIC},
@@ -1733,6 +4617,11 @@ static int register_genomicsqlite_functions(sqlite3 *db, const char **pzErrMsg,
                  {FPNM(twobit_rna), 2, SQLITE_DETERMINISTIC},
                  {FPNM(twobit_rna), 3, SQLITE_DETERMINISTIC},
                  {FPNM(dna_revcomp), 1, SQLITE_DETERMINISTIC},
+                 {FPNM(twobit_revcomp), 1, SQLITE_DETERMINISTIC},
+                 {FPNM(uint_key), 1, SQLITE_DETERMINISTIC},
+                 {FPNM(binary_json), 1, SQLITE_DETERMINISTIC},
+                 {FPNM(binary_json_extract), 2, SQLITE_DETERMINISTIC},
+                 {FPNM(binary_json_text), 1, SQLITE_DETERMINISTIC},
                  {FPNM(parse_genomic_range_sequence), 1, SQLITE_DETERMINISTIC},
                  {FPNM(parse_genomic_range_begin), 1, SQLITE_DETERMINISTIC},
                  {FPNM(parse_genomic_range_end), 1, SQLITE_DETERMINISTIC}};
@@ -1750,6 +4639,29 @@ static int register_genomicsqlite_functions(sqlite3 *db, const char **pzErrMsg,
             return rc;
         }
     }
+    // gri_rid() & gri_refseq_name() share a per-connection RefseqCache, so they're registered
+    // apart from fntab (whose entries have no per-connection state)
+    RefseqCache *refseq_cache = new (std::nothrow) RefseqCache;
+    if (!refseq_cache) {
+        return SQLITE_NOMEM;
+    }
+    refseq_cache->refcount = 1;
+    rc = sqlite3_create_function_v2(db, "gri_rid", 1, SQLITE_UTF8, refseq_cache, sqlfn_gri_rid,
+                                    nullptr, nullptr, refseq_cache_unref);
+    if (rc == SQLITE_OK) {
+        // on failure, sqlite3_create_function_v2 invokes the destructor itself
+        ++refseq_cache->refcount;
+        rc = sqlite3_create_function_v2(db, "gri_refseq_name", 1, SQLITE_UTF8, refseq_cache,
+                                        sqlfn_gri_refseq_name, nullptr, nullptr,
+                                        refseq_cache_unref);
+    }
+    if (rc != SQLITE_OK) {
+        if (pzErrMsg) {
+            *pzErrMsg = sqlite3_mprintf("Genomics Extension %s failed to register gri_rid",
+                                        GIT_REVISION);
+        }
+        return rc;
+    }
     rc = RegisterSQLiteVirtualTable<GenomicRangeIndexLevelsTVF>(db, "genomic_range_index_levels");
     if (rc != SQLITE_OK) {
         if (pzErrMsg) {
@@ -1767,6 +4679,47 @@ static int register_genomicsqlite_functions(sqlite3 *db, const char **pzErrMsg,
         }
         return rc;
     }
+    rc = RegisterSQLiteVirtualTable<GenomicRangeRowidRunsTVF>(db, "genomic_range_rowid_runs");
+    if (rc != SQLITE_OK) {
+        if (pzErrMsg) {
+            *pzErrMsg = sqlite3_mprintf(
+                "Genomics Extension %s failed to register genomic_range_rowid_runs", GIT_REVISION);
+        }
+        return rc;
+    }
+    rc = RegisterSQLiteVirtualTable<GenomicRangeRowidsBatchTVF>(db, "genomic_range_rowids_batch");
+    if (rc != SQLITE_OK) {
+        if (pzErrMsg) {
+            *pzErrMsg = sqlite3_mprintf(
+                "Genomics Extension %s failed to register genomic_range_rowids_batch",
+                GIT_REVISION);
+        }
+        return rc;
+    }
+    rc = RegisterSQLiteVirtualTable<GenomicRangeJoinTVF>(db, "genomic_range_join");
+    if (rc != SQLITE_OK) {
+        if (pzErrMsg) {
+            *pzErrMsg = sqlite3_mprintf(
+                "Genomics Extension %s failed to register genomic_range_join", GIT_REVISION);
+        }
+        return rc;
+    }
+    rc = RegisterSQLiteVirtualTable<ParseGenomicRangeTVF>(db, "parse_genomic_range");
+    if (rc != SQLITE_OK) {
+        if (pzErrMsg) {
+            *pzErrMsg = sqlite3_mprintf(
+                "Genomics Extension %s failed to register parse_genomic_range", GIT_REVISION);
+        }
+        return rc;
+    }
+    rc = RegisterSQLiteVirtualTable<VFSStatsTVF>(db, "genomicsqlite_vfs_stats");
+    if (rc != SQLITE_OK) {
+        if (pzErrMsg) {
+            *pzErrMsg = sqlite3_mprintf(
+                "Genomics Extension %s failed to register genomicsqlite_vfs_stats", GIT_REVISION);
+        }
+        return rc;
+    }
     // other extensions may return SQLITE_BUSY if another version is already loaded; that is
     // tolerable.
     if (sqlite3_libversion_number() < 3038000) { // JSON1 is bundled in SQLite 3.38.0 & above
@@ -4,6 +4,12 @@
 #include <stdlib.h>
 #include <string.h>
 
+int scan_callback(void *ctx, sqlite3_stmt *row) {
+    (void)row;
+    ++*(sqlite3_int64 *)ctx;
+    return 0;
+}
+
 int sql_callback(void *ctx, int nCol, char **values, char **names) {
     fprintf(stderr, "sql_callback(%d,\"%s\")\n", nCol, values[0] ? values[0] : "");
     char *ans = (char *)ctx;
@@ -83,6 +89,116 @@ int main(int argc, char **argv) {
     fprintf(stderr, "sqlite3_free()\n");
     sqlite3_free(sql);
 
+    fprintf(stderr, "create_genomic_range_index() @%d\n", sqlite3_total_changes(pDb));
+    rc = sqlite3_exec(pDb, "CREATE TABLE test(rid INTEGER, beg INTEGER, end INTEGER)", 0, 0,
+                      &zErrMsg);
+    if (rc == SQLITE_OK) {
+        rc = create_genomic_range_index(pDb, "test", "rid", "beg", "end", -1, &zErrMsg);
+    }
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "create_genomic_range_index -> %d // %s\n", rc,
+                zErrMsg ? zErrMsg : sqlite3_errstr(rc));
+        return 1;
+    }
+
+    fprintf(stderr, "genomicsqlite_twobit_fetch()\n");
+    rc = sqlite3_exec(pDb,
+                      "CREATE TABLE seq(seq_twobit BLOB);"
+                      "INSERT INTO seq(seq_twobit) VALUES(nucleotides_twobit('ACGTACGTTT'))",
+                      0, 0, &zErrMsg);
+    char window[5];
+    if (rc == SQLITE_OK) {
+        rc = genomicsqlite_twobit_fetch(pDb, "seq", "seq_twobit", 1, 2, 4, window, &zErrMsg);
+    }
+    if (rc != SQLITE_OK || strcmp(window, "GTAC")) {
+        fprintf(stderr, "genomicsqlite_twobit_fetch -> %d // %s\n", rc,
+                zErrMsg ? zErrMsg : sqlite3_errstr(rc));
+        return 1;
+    }
+
+    fprintf(stderr, "sqlite3_close()\n");
+    rc = sqlite3_close(pDb);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "sqlite3_close -> %d %s\n", rc, sqlite3_errstr(rc));
+        return 1;
+    }
+
+    fprintf(stderr, "genomicsqlite_pool_create()\n");
+    genomicsqlite_pool *pool = 0;
+    rc = genomicsqlite_pool_create(dbfilename, SQLITE_OPEN_READONLY, "{}", 2, &pool, &zErrMsg);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "genomicsqlite_pool_create -> %d // %s\n", rc,
+                zErrMsg ? zErrMsg : sqlite3_errstr(rc));
+        return 1;
+    }
+    sqlite3 *pDb2 = 0;
+    fprintf(stderr, "genomicsqlite_pool_checkout()\n");
+    rc = genomicsqlite_pool_checkout(pool, &pDb, &zErrMsg);
+    if (rc == SQLITE_OK) {
+        rc = genomicsqlite_pool_checkout(pool, &pDb2, &zErrMsg);
+    }
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "genomicsqlite_pool_checkout -> %d // %s\n", rc,
+                zErrMsg ? zErrMsg : sqlite3_errstr(rc));
+        return 1;
+    }
+    fprintf(stderr, "genomicsqlite_pool_checkin()\n");
+    genomicsqlite_pool_checkin(pool, pDb2);
+    genomicsqlite_pool_checkin(pool, pDb);
+    fprintf(stderr, "genomicsqlite_pool_checkout() again\n");
+    rc = genomicsqlite_pool_checkout(pool, &pDb2, &zErrMsg);
+    if (rc != SQLITE_OK || pDb2 != pDb) {
+        fprintf(stderr, "genomicsqlite_pool_checkout didn't reuse idle connection\n");
+        return 1;
+    }
+    version[0] = 0;
+    rc = sqlite3_exec(pDb2, "SELECT genomicsqlite_version()", &sql_callback, version, &zErrMsg);
+    if (rc != SQLITE_OK || !version[0]) {
+        fprintf(stderr, "pooled connection sqlite3_exec -> %d // %s\n", rc,
+                zErrMsg ? zErrMsg : sqlite3_errstr(rc));
+        return 1;
+    }
+    genomicsqlite_pool_checkin(pool, pDb2);
+    fprintf(stderr, "genomicsqlite_pool_destroy()\n");
+    genomicsqlite_pool_destroy(pool);
+
+    fprintf(stderr, "genomicsqlite_parallel_scan()\n");
+    sqlite3_int64 cb_rows = 0, rows = 0;
+    rc = genomicsqlite_parallel_scan(dbfilename, "{}",
+                                     "SELECT COUNT(*) FROM test WHERE test._gri_rid = ?1", 4,
+                                     scan_callback, &cb_rows, &rows, &zErrMsg);
+    if (rc != SQLITE_OK || rows != cb_rows || !rows) {
+        fprintf(stderr, "genomicsqlite_parallel_scan -> %d (%d rows) // %s\n", rc, (int)rows,
+                zErrMsg ? zErrMsg : sqlite3_errstr(rc));
+        return 1;
+    }
+
+    fprintf(stderr, "genomicsqlite_vacuum_into()\n");
+    char *destfilename = tempnam("/tmp", "gsqlt");
+    if (!destfilename) {
+        fprintf(stderr, "tempnam -> %d\n", errno);
+        return 1;
+    }
+    rc = genomicsqlite_vacuum_into(dbfilename, destfilename, &zErrMsg, "{}");
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "genomicsqlite_vacuum_into -> %d // %s\n", rc,
+                zErrMsg ? zErrMsg : sqlite3_errstr(rc));
+        return 1;
+    }
+    fprintf(stderr, "genomicsqlite_open() vacuumed copy\n");
+    rc = genomicsqlite_open(destfilename, &pDb, &zErrMsg, SQLITE_OPEN_READONLY, "{}");
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "genomicsqlite_open(vacuumed copy) -> %d // %s\n", rc,
+                zErrMsg ? zErrMsg : sqlite3_errstr(rc));
+        return 1;
+    }
+    window[0] = 0;
+    rc = genomicsqlite_twobit_fetch(pDb, "seq", "seq_twobit", 1, 2, 4, window, &zErrMsg);
+    if (rc != SQLITE_OK || strcmp(window, "GTAC")) {
+        fprintf(stderr, "genomicsqlite_twobit_fetch(vacuumed copy) -> %d // %s\n", rc,
+                zErrMsg ? zErrMsg : sqlite3_errstr(rc));
+        return 1;
+    }
     fprintf(stderr, "sqlite3_close()\n");
     rc = sqlite3_close(pDb);
     if (rc != SQLITE_OK) {
@@ -66,3 +66,40 @@ def test_bam(tmp_path):
         )
     )
     assert (mq_hist[0], mq_hist[60]) == (2734, 520522)
+
+
+def test_tags_binary_json(tmp_path):
+    # --tags-binary-json stores reads_tags.tags_json as binary JSON; it should round-trip through
+    # binary_json_text()/binary_json_extract() to the same values as the default TEXT load
+    bamfile = os.path.join(HERE, "data/NA12878.chr21:20000000-22500000.bam")
+    text_db = str(tmp_path / "text.bam.sqlite")
+    sam_into_sqlite(bamfile, text_db)
+    blob_db = str(tmp_path / "blob.bam.sqlite")
+    sam_into_sqlite(bamfile, blob_db, "--tags-binary-json")
+
+    con = genomicsqlite.connect(blob_db, read_only=True)
+    assert list(con.execute("SELECT DISTINCT typeof(tags_json) FROM reads_tags")) == [("blob",)]
+
+    con.executescript(genomicsqlite.attach_sql(con, text_db, "control", immutable=True))
+    mismatched = next(
+        con.execute(
+            """
+            SELECT COUNT(*) FROM reads_tags, control.reads_tags AS control_tags
+            WHERE reads_tags._rowid_ = control_tags._rowid_
+                AND json(binary_json_text(reads_tags.tags_json)) <> json(control_tags.tags_json)
+            """
+        )
+    )[0]
+    assert mismatched == 0
+
+    mq_hist = dict(
+        con.execute(
+            """
+            SELECT mq, COUNT(*) as count FROM
+                (SELECT ifnull(binary_json_extract(tags_json, '$.MQ'),0) AS mq
+                FROM reads NATURAL JOIN reads_tags WHERE (flag & 3840) = 0)
+            GROUP BY mq ORDER BY mq DESC
+            """
+        )
+    )
+    assert (mq_hist[0], mq_hist[60]) == (2734, 520522)
@@ -1,3 +1,5 @@
+import sqlite3
+import pytest
 import genomicsqlite
 
 
@@ -17,3 +19,184 @@ def test_bundled_extensions():
         "SELECT json_extract(json,'$.chrom') AS chrom FROM test ORDER BY chrom COLLATE UINT"
     )
     assert list(results) == [("chr2",), ("chr10",), ("chrMT",)]
+
+
+def test_vfs_stats(tmp_path):
+    con = genomicsqlite.connect(str(tmp_path / "test.gsql"))
+
+    stats = dict(con.execute("SELECT name, value FROM genomicsqlite_vfs_stats()"))
+    for name in ("page_cache_hit", "page_cache_miss", "page_cache_write", "memory_used"):
+        assert name in stats and isinstance(stats[name], int) and stats[name] >= 0
+
+    con.executescript(
+        """
+        CREATE TABLE test(x INTEGER);
+        INSERT INTO test(x) VALUES(42);
+        """
+    )
+    con.commit()
+
+    stats2 = dict(con.execute("SELECT name, value FROM genomicsqlite_vfs_stats()"))
+    assert stats2["page_cache_write"] > stats["page_cache_write"]
+
+
+def test_shared_cache(tmp_path):
+    dbfile = str(tmp_path / "test.gsql")
+    con = genomicsqlite.connect(dbfile)
+    con.executescript(
+        """
+        CREATE TABLE test(x INTEGER);
+        INSERT INTO test(x) VALUES(42);
+        """
+    )
+    con.commit()
+
+    uri = next(con.execute("SELECT genomicsqlite_uri(?,?)", (dbfile, '{"shared_cache": true}')))[0]
+    assert "cache=shared" in uri
+    assert "cache=shared" not in next(con.execute("SELECT genomicsqlite_uri(?)", (dbfile,)))[0]
+    con.close()
+
+    readers = [
+        genomicsqlite.connect(dbfile, read_only=True, shared_cache=True, immutable=True)
+        for _ in range(4)
+    ]
+    for reader in readers:
+        assert next(reader.execute("SELECT x FROM test"))[0] == 42
+    for reader in readers:
+        reader.close()
+
+
+def test_uint_key():
+    import random
+
+    con = genomicsqlite.connect(":memory:")
+    con.execute("CREATE TABLE test(name TEXT)")
+
+    random.seed(42)
+    alphabet = "0123456789chrXYMT_:-."
+    names = ["chr1", "chr2", "chr10", "chrM", "x00123y", "x123y", "0", ""]
+    names += ["".join(random.choices(alphabet, k=random.randint(0, 12))) for _ in range(1000)]
+    con.executemany("INSERT INTO test(name) VALUES(?)", ((name,) for name in names))
+
+    # BINARY order of the precomputed keys == UINT collation order of the names
+    by_uint = list(con.execute("SELECT name FROM test ORDER BY name COLLATE UINT, _rowid_"))
+    by_key = list(con.execute("SELECT name FROM test ORDER BY uint_key(name), _rowid_"))
+    assert by_key == by_uint
+
+    # UINT-equal strings get byte-identical keys
+    assert next(con.execute("SELECT uint_key('x00123y') = uint_key('x123y')"))[0] == 1
+    assert next(con.execute("SELECT uint_key(NULL)"))[0] is None
+    with pytest.raises(sqlite3.OperationalError):
+        con.execute("SELECT uint_key(42)")
+
+
+def test_binary_json():
+    con = genomicsqlite.connect(":memory:")
+
+    # round trip through the binary encoding preserves JSON semantics
+    docs = [
+        "{}",
+        "[]",
+        "null",
+        '{"MQ":60,"NM":0,"AS":-12,"RG":"rg1"}',
+        '{"a":{"b":[10,20,{"c":"hi"}]},"pi":3.25,"t":true,"f":false,"z":null}',
+        '[{"k":1},{"k":2},{"k":{"k":3}}]',
+        '{"esc":"a\\"b\\\\c\\n\\u00e9"}',
+    ]
+    for doc in docs:
+        row = next(
+            con.execute(
+                "SELECT json(binary_json_text(binary_json(?1))) = json(?1), typeof(binary_json(?1))",
+                (doc,),
+            )
+        )
+        assert row == (1, "blob"), doc
+
+    # extraction agrees with json_extract() on text
+    doc = '{"MQ":60,"NM":0,"frac":0.5,"RG":"rg1","deep":{"list":[1,2,3]}}'
+    for path in ("$.MQ", "$.NM", "$.frac", "$.RG", "$.deep.list[1]", "$.deep.list", "$.absent"):
+        row = next(
+            con.execute(
+                "SELECT binary_json_extract(binary_json(?1), ?2), json_extract(?1, ?2)",
+                (doc, path),
+            )
+        )
+        assert row[0] == row[1], path
+
+    # binary_json() is idempotent; binary_json_text() passes text through
+    assert (
+        next(con.execute("SELECT binary_json(binary_json(?1)) = binary_json(?1)", (doc,)))[0] == 1
+    )
+    assert next(con.execute("SELECT binary_json_text(?1)", (doc,)))[0] == doc
+
+    # NULL propagation & error cases
+    assert next(con.execute("SELECT binary_json(NULL)"))[0] is None
+    assert next(con.execute("SELECT binary_json_extract(binary_json('{}'), NULL)"))[0] is None
+    with pytest.raises(sqlite3.OperationalError):
+        con.execute("SELECT binary_json('{nope')")
+    with pytest.raises(sqlite3.OperationalError):
+        con.execute("SELECT binary_json(42)")
+    with pytest.raises(sqlite3.OperationalError):
+        con.execute("SELECT binary_json_extract(binary_json('{}'), 'no_dollar')")
+    with pytest.raises(sqlite3.OperationalError):
+        con.execute("SELECT binary_json_text(x'00112233')")
+
+
+def test_web_uri_prefetch():
+    con = genomicsqlite.connect(":memory:")
+    config = '{"threads": 4, "inner_page_KiB": 2}'
+
+    # small inner pages suppress prefetch locally...
+    local_uri = next(con.execute("SELECT genomicsqlite_uri('/tmp/test.gsql', ?)", (config,)))[0]
+    assert "noprefetch=1" in local_uri
+
+    # ...but not over http(s), where the prefetch pool keeps concurrent ranged GETs in flight
+    web_uri = next(
+        con.execute("SELECT genomicsqlite_uri('https://example.org/test.gsql', ?)", (config,))
+    )[0]
+    assert "web_url=" in web_uri
+    assert "noprefetch" not in web_uri
+
+
+def test_frozen(tmp_path):
+    dbfile = str(tmp_path / "test.gsql")
+    con = genomicsqlite.connect(dbfile, unsafe_load=True)
+    con.executescript(
+        """
+        CREATE TABLE test(x INTEGER);
+        INSERT INTO test(x) VALUES(1),(2),(3);
+        """
+    )
+    con.commit()
+
+    frozen_file = str(tmp_path / "frozen.db")
+    vacuum_sql = next(
+        con.execute("SELECT genomicsqlite_vacuum_into_sql(?,?)", (frozen_file, '{"frozen": true}'))
+    )[0]
+    assert "vfs=zstd" not in vacuum_sql
+    con.executescript(vacuum_sql)
+    con.close()
+
+    # frozen export is a plain SQLite file, readable by stock sqlite3 without the extension
+    raw = sqlite3.connect(frozen_file)
+    assert next(raw.execute("SELECT SUM(x) FROM test"))[0] == 6
+    raw.close()
+
+    # ...and opening it through the extension with frozen=True serves reads via mmap
+    fz = genomicsqlite.connect(frozen_file, read_only=True, frozen=True, immutable=True)
+    uri = next(
+        fz.execute(
+            "SELECT genomicsqlite_uri(?,?)", (frozen_file, '{"frozen": true, "immutable": true}')
+        )
+    )[0]
+    assert "vfs=zstd" not in uri and "immutable=1" in uri
+    assert next(fz.execute("PRAGMA mmap_size"))[0] > 0
+    assert next(fz.execute("SELECT SUM(x) FROM test"))[0] == 6
+    with pytest.raises(sqlite3.OperationalError):
+        fz.execute("INSERT INTO test(x) VALUES(4)")
+    fz.close()
+
+    with pytest.raises(sqlite3.OperationalError, match="local files"):
+        genomicsqlite.connect(":memory:").execute(
+            "SELECT genomicsqlite_uri('https://example.org/test.gsql', '{\"frozen\": true}')"
+        )
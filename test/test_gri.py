@@ -437,6 +437,336 @@ def test_query_in_sql(tmp_path):
     assert not results
 
 
+def test_rowid_runs(tmp_path):
+    dbfile = str(tmp_path / "test.gsql")
+    con = genomicsqlite.connect(dbfile, unsafe_load=True)
+    _fill_exons(con)
+    con.commit()
+
+    args = ("chr17", 43044294, 43123973)
+    rowids = [row[0] for row in con.execute("SELECT * FROM genomic_range_rowids('exons',?,?,?)", args)]
+    runs = list(con.execute("SELECT * FROM genomic_range_rowid_runs('exons',?,?,?)", args))
+    assert rowids
+    assert len(runs) <= len(rowids)
+    # runs expand to exactly the rowid set, in order, without overlap
+    expanded = []
+    for first_rowid, last_rowid in runs:
+        assert first_rowid <= last_rowid
+        assert not expanded or first_rowid > expanded[-1] + 1
+        expanded.extend(range(first_rowid, last_rowid + 1))
+    assert expanded == rowids
+
+    # fetching each run with a BETWEEN range scan retrieves the same exons
+    query = """
+        SELECT id FROM exons, genomic_range_rowid_runs('exons',?,?,?)
+            WHERE exons._rowid_ BETWEEN first_rowid AND last_rowid
+        """
+    control_query = "SELECT id FROM exons WHERE exons._rowid_ IN genomic_range_rowids('exons',?,?,?)"
+    assert list(con.execute(query, args)) == list(con.execute(control_query, args))
+
+    # coordinate-sorted load => one run per contiguous stretch
+    con.executescript("CREATE TABLE sorted_features(rid INTEGER, beg INTEGER, end INTEGER)")
+    con.executemany(
+        "INSERT INTO sorted_features(rid,beg,end) VALUES(?,?,?)",
+        ((1, beg, beg + 50) for beg in range(0, 100000, 100)),
+    )
+    con.executescript(
+        genomicsqlite.create_genomic_range_index_sql(con, "sorted_features", "rid", "beg", "end")
+    )
+    runs = list(con.execute("SELECT * FROM genomic_range_rowid_runs('sorted_features',1,0,100000)"))
+    assert runs == [(1, 1000)]
+    assert not list(con.execute("SELECT * FROM genomic_range_rowid_runs('sorted_features',2,0,100000)"))
+
+    with pytest.raises(sqlite3.OperationalError, match="no such table"):
+        con.execute("SELECT * FROM genomic_range_rowid_runs('nonexistent', 'chr17', 0, 1)")
+    with pytest.raises(sqlite3.OperationalError, match="domain error"):
+        con.execute("SELECT * FROM genomic_range_rowid_runs('exons', 'chr17', 0, 1, 16, 0)")
+
+
+def test_batched_in(tmp_path):
+    dbfile = str(tmp_path / "test.gsql")
+    con = genomicsqlite.connect(dbfile, unsafe_load=True)
+    con.executescript("CREATE TABLE features(rid INTEGER, beg INTEGER, end INTEGER)")
+    con.executemany(
+        "INSERT INTO features(rid,beg,end) VALUES(?,?,?)",
+        ((rid, beg, beg + 50) for rid in (1, 2, 3) for beg in range(0, 10000, 100)),
+    )
+    con.executescript(
+        genomicsqlite.create_genomic_range_index_sql(con, "features", "rid", "beg", "end")
+    )
+    con.commit()
+
+    # qrid IN (...) is consumed as one batched value list (SQLite >= 3.38), producing the sorted
+    # union of the per-rid results in a single merged sweep
+    batched = [
+        row[0]
+        for row in con.execute(
+            "SELECT _rowid_ FROM genomic_range_rowids"
+            " WHERE tableName='features' AND qrid IN (1,3) AND qbeg=0 AND qend=5000"
+        )
+    ]
+    control = [
+        row[0]
+        for qrid in (1, 3)
+        for row in con.execute("SELECT * FROM genomic_range_rowids('features',?,0,5000)", (qrid,))
+    ]
+    assert batched and batched == sorted(control)
+
+    # duplicate values in the list don't duplicate results
+    dupes = [
+        row[0]
+        for row in con.execute(
+            "SELECT _rowid_ FROM genomic_range_rowids"
+            " WHERE tableName='features' AND qrid IN (1,1,3,3) AND qbeg=0 AND qend=5000"
+        )
+    ]
+    assert dupes == batched
+
+    # genomic_range_rowid_runs() compresses the merged sweep
+    runs = list(
+        con.execute(
+            "SELECT first_rowid, last_rowid FROM genomic_range_rowid_runs"
+            " WHERE tableName='features' AND qrid IN (1,3) AND qbeg=0 AND qend=5000"
+        )
+    )
+    expanded = [rowid for first_rowid, last_rowid in runs for rowid in range(first_rowid, last_rowid + 1)]
+    assert expanded == batched
+
+    # no matching partitions
+    assert not list(
+        con.execute(
+            "SELECT _rowid_ FROM genomic_range_rowids"
+            " WHERE tableName='features' AND qrid IN (7,8) AND qbeg=0 AND qend=5000"
+        )
+    )
+
+
+def test_stmt_cache_alternation(tmp_path):
+    # alternating level bounds keep their own warm prepared statements, keyed on
+    # (table, ceiling, floor) with LRU eviction; results must stay correct throughout
+    dbfile = str(tmp_path / "test.gsql")
+    con = genomicsqlite.connect(dbfile, unsafe_load=True)
+    _fill_exons(con)
+    _fill_exons(con, table="exons2")
+    con.commit()
+
+    args = ("chr17", 43044294, 43123973)
+    combos = []
+    for table in ("exons", "exons2"):
+        lvls = [
+            row[0]
+            for row in con.execute(
+                f"SELECT DISTINCT -_gri_lvl FROM {table} WHERE _gri_lvl IS NOT NULL"
+            )
+        ]
+        # bounds covering all occupied levels return the complete result set
+        for ceiling in range(max(lvls), 16):
+            for floor in range(0, min(lvls) + 1):
+                combos.append((table, ceiling, floor))
+    assert len(combos) > 64  # enough distinct keys to exercise LRU eviction
+
+    control = {
+        table: [
+            row[0]
+            for row in con.execute(
+                f"SELECT _rowid_ FROM {table} WHERE rid=? AND NOT (end < ? OR beg > ?) ORDER BY _rowid_",
+                args,
+            )
+        ]
+        for table in ("exons", "exons2")
+    }
+    assert control["exons"]
+    for _ in range(2):
+        for table, ceiling, floor in combos:
+            rowids = [
+                row[0]
+                for row in con.execute(
+                    f"SELECT * FROM genomic_range_rowids('{table}',?,?,?,{ceiling},{floor})", args
+                )
+            ]
+            assert rowids == control[table], (table, ceiling, floor)
+            runs = list(
+                con.execute(
+                    f"SELECT * FROM genomic_range_rowid_runs('{table}',?,?,?,{ceiling},{floor})",
+                    args,
+                )
+            )
+            expanded = [r for first, last in runs for r in range(first, last + 1)]
+            assert expanded == control[table], (table, ceiling, floor)
+
+
+def test_prefetch(tmp_path):
+    dbfile = str(tmp_path / "test.gsql")
+    con = genomicsqlite.connect(dbfile, unsafe_load=True)
+    _fill_exons(con)
+    con.commit()
+
+    args = ("chr17", 43044294, 43123973)
+    touched = next(con.execute("SELECT genomic_range_prefetch('exons',?,?,?)", args))[0]
+    control = next(
+        con.execute(
+            "SELECT COUNT(*) FROM exons WHERE exons._rowid_ IN genomic_range_rowids('exons',?,?,?)",
+            args,
+        )
+    )[0]
+    assert touched == control > 0
+
+    assert next(con.execute("SELECT genomic_range_prefetch('exons','chrZ',0,1)"))[0] == 0
+
+    with pytest.raises(sqlite3.OperationalError, match="no such table"):
+        con.execute("SELECT genomic_range_prefetch('nonexistent','chr17',0,1)")
+
+
+def test_persisted_levels(tmp_path):
+    dbfile = str(tmp_path / "test.gsql")
+    con = genomicsqlite.connect(dbfile, unsafe_load=True)
+    _fill_exons(con, floor=2)
+    con.executescript(genomicsqlite.put_genomic_range_index_levels_sql(con, "exons"))
+    con.commit()
+    assert list(con.execute("SELECT table_name, gri_ceiling, gri_floor FROM _gri_levels")) == [
+        ("exons", 3, 2)
+    ]
+    con.close()
+
+    # fresh connection picks up the persisted bounds without scanning the GRI
+    con = genomicsqlite.connect(dbfile)
+    assert list(
+        con.execute("SELECT _gri_ceiling, _gri_floor FROM genomic_range_index_levels('exons')")
+    ) == [(3, 2)]
+    results = list(
+        con.execute(
+            "SELECT id FROM exons WHERE _rowid_ IN genomic_range_rowids('exons',?,?,?)",
+            ("chr17", 43044294, 43048294),
+        )
+    )
+    control = list(
+        con.execute(
+            "SELECT id FROM exons NOT INDEXED WHERE rid = ? AND NOT (beg > ? OR end < ?)",
+            ("chr17", 43048294, 43044294),
+        )
+    )
+    assert sorted(results) == sorted(control)
+    con.close()
+
+    # the persisted bounds are a snapshot: after the table changes they must be refreshed
+    con = genomicsqlite.connect(dbfile)
+    con.execute(
+        "INSERT INTO exons(rid,beg,end,len,id) VALUES('chr17',43000000,44000000,1000000,'big')"
+    )
+    con.executescript(genomicsqlite.put_genomic_range_index_levels_sql(con, "exons"))
+    con.commit()
+    assert list(
+        con.execute("SELECT _gri_ceiling, _gri_floor FROM genomic_range_index_levels('exons')")
+    ) == [(5, 2)]
+
+
+def test_query_batch(tmp_path):
+    dbfile = str(tmp_path / "test.gsql")
+    con = genomicsqlite.connect(dbfile, unsafe_load=True)
+    _fill_exons(con)
+    con.execute("CREATE TABLE query_ranges(qrid TEXT, qbeg INTEGER, qend INTEGER)")
+    random.seed(42)
+    ranges = [
+        ("chr17", beg, beg + random.randint(1, 10000))
+        for beg in (random.randint(43000000, 43120000) for _ in range(100))
+    ]
+    con.executemany("INSERT INTO query_ranges(qrid,qbeg,qend) VALUES(?,?,?)", ranges)
+    con.commit()
+
+    results = list(
+        con.execute(
+            "SELECT query_ordinal, _rowid_ FROM genomic_range_rowids_batch('exons', 'query_ranges')"
+        )
+    )
+
+    # control: one genomic_range_rowids() invocation per range
+    control = []
+    for ordinal, (qrid, qbeg, qend) in enumerate(ranges, 1):
+        control += [
+            (ordinal, rowid)
+            for (rowid,) in con.execute(
+                "SELECT _rowid_ FROM genomic_range_rowids('exons',?,?,?)", (qrid, qbeg, qend)
+            )
+        ]
+    assert sorted(results) == sorted(control)
+    assert len(results) > 100
+
+    # each range's results arrive clustered & rowid-sorted
+    seen = set()
+    last = None
+    for ordinal, rowid in results:
+        if ordinal != last:
+            assert ordinal not in seen
+            seen.add(ordinal)
+            last = ordinal
+
+    # explicit ceiling & floor
+    results2 = list(
+        con.execute(
+            "SELECT query_ordinal, _rowid_ FROM genomic_range_rowids_batch('exons', 'query_ranges', 15, 0)"
+        )
+    )
+    assert sorted(results2) == sorted(control)
+
+    with pytest.raises(sqlite3.OperationalError, match="lacks GRI|no such"):
+        con.execute("SELECT * FROM genomic_range_rowids_batch('nonexistent', 'query_ranges')")
+    with pytest.raises(sqlite3.OperationalError, match="can't read query ranges"):
+        con.execute("SELECT * FROM genomic_range_rowids_batch('exons', 'nonexistent')")
+    con.execute("CREATE TABLE narrow(qrid TEXT)")
+    with pytest.raises(sqlite3.OperationalError, match=">= 3 columns"):
+        con.execute("SELECT * FROM genomic_range_rowids_batch('exons', 'narrow')")
+
+
+def test_range_join(tmp_path):
+    dbfile = str(tmp_path / "test.gsql")
+    con = genomicsqlite.connect(dbfile, unsafe_load=True)
+    _fill_exons(con, table="exons")
+    _fill_exons(con, table="exons2")
+    con.commit()
+
+    results = list(
+        con.execute(
+            "SELECT left_rowid, right_rowid FROM genomic_range_join('exons', 'exons2')"
+        )
+    )
+
+    # control: nested per-row genomic_range_rowids() join
+    control = list(
+        con.execute(
+            """
+            SELECT exons._rowid_, exons2._rowid_ FROM exons, exons2
+                WHERE exons2._rowid_ IN
+                    genomic_range_rowids('exons2', exons.rid, exons.beg, exons.end)
+            """
+        )
+    )
+    assert sorted(results) == sorted(control)
+    assert len(results) > len(_EXONS.strip().split("\n"))
+
+    # self-join & join with an empty table
+    results = list(con.execute("SELECT * FROM genomic_range_join('exons', 'exons')"))
+    control = list(
+        con.execute(
+            """
+            SELECT exons._rowid_, e2._rowid_ FROM exons, exons AS e2
+                WHERE e2._rowid_ IN genomic_range_rowids('exons', exons.rid, exons.beg, exons.end)
+            """
+        )
+    )
+    assert sorted(results) == sorted(control)
+
+    con.executescript("CREATE TABLE empty(rid TEXT, beg INTEGER, end INTEGER)")
+    con.executescript(
+        genomicsqlite.create_genomic_range_index_sql(con, "empty", "rid", "beg", "end")
+    )
+    assert not list(con.execute("SELECT * FROM genomic_range_join('exons', 'empty')"))
+    assert not list(con.execute("SELECT * FROM genomic_range_join('empty', 'exons')"))
+
+    con.executescript("CREATE TABLE nogri(rid TEXT, beg INTEGER, end INTEGER)")
+    with pytest.raises(sqlite3.OperationalError, match="missing genomic range index"):
+        con.execute("SELECT * FROM genomic_range_join('exons', 'nogri')")
+
+
 def _fill_exons(con, floor=None, table="exons", gri=True, len_gri=False):
     con.execute(
         f"CREATE TABLE {table}(rid TEXT NOT NULL, beg INTEGER NOT NULL, end INTEGER NOT NULL, len INTEGER NOT NULL, id TEXT NOT NULL)"
@@ -810,3 +1140,22 @@ chr17	43115725	43115779	ENST00000476777.5_exon_6_0_chr17_43115726_r	0	-
 chr17	43124016	43124115	ENST00000476777.5_exon_7_0_chr17_43124017_r	0	-
 chr17	43125270	43125353	ENST00000476777.5_exon_8_0_chr17_43125271_r	0	-
 """
+
+
+def test_gri_refseq_lookup():
+    con = genomicsqlite.connect(":memory:")
+    con.executescript(genomicsqlite.put_reference_assembly_sql(con, "GRCh38_no_alt_analysis_set"))
+    con.commit()
+
+    assert next(con.execute("SELECT gri_rid('chr17')"))[0] == 17
+    assert next(con.execute("SELECT gri_refseq_name(17)"))[0] == "chr17"
+    assert next(con.execute("SELECT gri_rid('bogus')"))[0] is None
+    assert next(con.execute("SELECT gri_refseq_name(-1)"))[0] is None
+    assert next(con.execute("SELECT gri_rid(NULL)"))[0] is None
+    assert next(con.execute("SELECT gri_refseq_name(NULL)"))[0] is None
+
+    # cache invalidates when _gri_refseq changes
+    con.executescript(genomicsqlite.put_reference_sequence_sql(con, "chrTest", 1234, rid=1000))
+    con.commit()
+    assert next(con.execute("SELECT gri_rid('chrTest')"))[0] == 1000
+    assert next(con.execute("SELECT gri_refseq_name(1000)"))[0] == "chrTest"
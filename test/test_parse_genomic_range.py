@@ -40,3 +40,31 @@ def test_parse_genomic_range():
         assert "parse_genomic_range():" in str(exc.value)
 
     assert next(con.execute("SELECT parse_genomic_range_end(NULL)"))[0] is None
+
+
+def test_parse_genomic_range_tvf():
+    con = genomicsqlite.connect(":memory:")
+    for txt, chrom, begin_pos, end_pos in [
+        ("chr1:2,345-06,789", "chr1", 2344, 6789),
+        ("π:1-9,223,372,036,854,775,799", "π", 0, 9223372036854775799),
+    ]:
+        assert list(con.execute("SELECT * FROM parse_genomic_range(?)", (txt,))) == [
+            (chrom, begin_pos, end_pos)
+        ]
+
+    # one row per input row when joined
+    con.executescript(
+        """
+        CREATE TABLE ranges(txt TEXT);
+        INSERT INTO ranges(txt) VALUES('chr1:2,345-06,789'), ('chr2:1-100'), (NULL);
+        """
+    )
+    rows = list(
+        con.execute('SELECT sequence, "begin", "end" FROM ranges, parse_genomic_range(ranges.txt)')
+    )
+    assert rows == [("chr1", 2344, 6789), ("chr2", 0, 100), (None, None, None)]
+
+    for txt in ["", ":", "chr1:0-1", "chr1:2345-deadbeef"]:
+        with pytest.raises(sqlite3.OperationalError) as exc:
+            con.execute("SELECT * FROM parse_genomic_range(?)", (txt,)).fetchall()
+        assert "parse_genomic_range():" in str(exc.value)
@@ -54,6 +54,36 @@ def test_twobit_random():
         assert decoded == control
 
 
+def test_twobit_long_sequences():
+    # exercise the vectorized encode path: long sequences, all chunk-boundary phases, and
+    # invalid characters planted at various positions (forcing scalar fallback mid-sequence)
+    con = genomicsqlite.connect(":memory:")
+
+    random.seed(12345)
+    for trial in range(100):
+        seqlen = random.randint(48, 4096)
+        seq = "".join(random.choice("AGCTagct") for _ in range(seqlen))
+        assert next(con.execute("SELECT twobit_dna(nucleotides_twobit(?))", (seq,)))[0] == seq.upper()
+        # plant a non-nucleotide character; encoding should pass the text through unchanged
+        pos = random.randint(0, seqlen - 1)
+        bad = seq[:pos] + "N" + seq[pos + 1 :]
+        assert next(con.execute("SELECT nucleotides_twobit(?)", (bad,)))[0] == bad
+
+    # long-sequence decode with substring windows crossing vector chunk boundaries
+    seq = "".join(random.choice("ACGT") for _ in range(65536))
+    for _ in range(100):
+        sub_ofs = random.randint(1, 65536)
+        sub_len = random.randint(0, 1024)
+        assert (
+            next(
+                con.execute(
+                    "SELECT twobit_dna(nucleotides_twobit(?),?,?)", (seq, sub_ofs, sub_len)
+                )
+            )[0]
+            == seq[sub_ofs - 1 : sub_ofs - 1 + sub_len]
+        )
+
+
 def test_twobit_corner_cases():
     con = genomicsqlite.connect(":memory:")
 
@@ -118,3 +148,32 @@ def test_dna_revcomp():
 
     with pytest.raises(sqlite3.OperationalError, match="argument #1 type mismatch"):
         con.execute("SELECT dna_revcomp(42)")
+
+
+def test_twobit_revcomp():
+    con = genomicsqlite.connect(":memory:")
+
+    # packed reverse complement == re-encoding the text reverse complement, byte-for-byte
+    random.seed(616)
+    for seqlen in [0, 1, 2, 3, 4, 5, 6, 7, 8] + [random.randint(9, 5000) for _ in range(500)]:
+        seq = "".join(random.choice("AGCTagct") for _ in range(seqlen))
+        (got, expect) = next(
+            con.execute(
+                "SELECT twobit_revcomp(nucleotides_twobit(?)), nucleotides_twobit(dna_revcomp(?))",
+                (seq, seq),
+            )
+        )
+        assert got == expect, seq
+        assert (
+            next(con.execute("SELECT twobit_dna(twobit_revcomp(nucleotides_twobit(?)))", (seq,)))[0]
+            == next(con.execute("SELECT upper(dna_revcomp(?))", (seq,)))[0]
+        )
+
+    # text input passes through dna_revcomp() semantics; NULL propagates
+    assert next(con.execute("SELECT twobit_revcomp('gATtaCa')"))[0] == "tGtaATc"
+    assert next(con.execute("SELECT twobit_revcomp(NULL)"))[0] is None
+
+    with pytest.raises(sqlite3.OperationalError, match="non-DNA input to twobit_revcomp()"):
+        con.execute("SELECT twobit_revcomp('GATTACAb')")
+    with pytest.raises(sqlite3.OperationalError, match="expected BLOB or TEXT"):
+        con.execute("SELECT twobit_revcomp(42)")
@@ -124,6 +124,25 @@ def test_pvcf_glnexus(tmp_path):
     # ...exercise JSON1 queries
 
 
+def test_genotype_shards(tmp_path):
+    # sharded genotype ingestion should yield exactly the same genotypes table as the serial path
+    infilename = os.path.join(HERE, "data/dv_glnexus.1KGP.ALDH2.vcf.gz")
+    serial = str(tmp_path / "serial.gsql")
+    vcf_into_sqlite(infilename, serial)
+    sharded = str(tmp_path / "sharded.gsql")
+    vcf_into_sqlite(infilename, sharded, "--genotype-shards", "4")
+
+    con = genomicsqlite.connect(sharded, read_only=True)
+    con.executescript(genomicsqlite.attach_sql(con, serial, "control", immutable=True))
+    assert next(con.execute("SELECT COUNT(*) FROM genotypes")) == next(
+        con.execute("SELECT COUNT(*) FROM control.genotypes")
+    )
+    assert not list(con.execute("SELECT * FROM genotypes EXCEPT SELECT * FROM control.genotypes"))
+    assert not list(con.execute("SELECT * FROM control.genotypes EXCEPT SELECT * FROM genotypes"))
+    # shard files should have been cleaned up
+    assert not [fn for fn in os.listdir(tmp_path) if "shard" in fn]
+
+
 def test_pvcf_gatk(tmp_path):
     dbfile = str(tmp_path / "test.gsql")
     vcf_into_sqlite(os.path.join(HERE, "data/gatk.1KGP.ALDH2.vcf.gz"), str(dbfile))
@@ -91,6 +91,24 @@ def test_pvcf_glnexus(tmp_path):
     assert next(con.execute("SELECT SUM(rlen) FROM vcf_lines")) == (2560,)
 
 
+def test_bgzf_direct(tmp_path):
+    # feeding the bgzip file directly engages block-parallel decompression; results should be
+    # byte-identical to the serial text pipe
+    infilename = os.path.join(HERE, "data/gnomad.r3.0.sites.ALDH2.vcf.bgz")
+    piped = str(tmp_path / "piped.gsql")
+    vcf_lines_into_sqlite(infilename, piped)
+    direct = str(tmp_path / "direct.gsql")
+    cmd = f"{os.path.join(BUILD, 'loaders/vcf_lines_into_sqlite')} -@ 4 {direct} < {infilename}"
+    print(cmd)
+    subprocess.run(cmd, check=True, shell=True)
+
+    con1 = genomicsqlite.connect(piped, read_only=True)
+    con2 = genomicsqlite.connect(direct, read_only=True)
+    lines1 = list(con1.execute("SELECT CHROM, POS, rlen, line FROM vcf_lines ORDER BY _rowid_"))
+    lines2 = list(con2.execute("SELECT CHROM, POS, rlen, line FROM vcf_lines ORDER BY _rowid_"))
+    assert lines1 and lines1 == lines2
+
+
 def test_pvcf_gatk(tmp_path):
     dbfile = str(tmp_path / "gatk_pvcf_lines.gsql")
     vcf_lines_into_sqlite(os.path.join(HERE, "data/gatk.1KGP.ALDH2.vcf.gz"), str(dbfile))